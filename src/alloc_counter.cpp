@@ -0,0 +1,42 @@
+/**@file alloc_counter.cpp
+ * @brief contains the replacement of the global operator new.
+ *
+ */
+
+#include "alloc_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long> allocation_count (0);
+
+/**@brief Get the number of allocations made since the start of the program
+ *
+ * @return allocations made through operator new by every thread
+ */
+auto
+get_allocation_count () -> unsigned long
+{
+  return allocation_count.load (std::memory_order_relaxed);
+}
+
+void *
+operator new (std::size_t size)
+{
+  allocation_count.fetch_add (1, std::memory_order_relaxed);
+  if (auto *ptr = std::malloc (size ? size : 1))
+    return ptr;
+  throw std::bad_alloc ();
+}
+
+void
+operator delete (void *ptr) noexcept
+{
+  std::free (ptr);
+}
+
+void
+operator delete (void *ptr, std::size_t) noexcept
+{
+  std::free (ptr);
+}
@@ -0,0 +1,19 @@
+/**@file alloc_counter.hpp
+ * @brief contains the heap allocation counter
+ *
+ * alloc_counter.cpp replaces the global operator new of the program it is
+ * linked into and counts every allocation made through it, from every
+ * thread. Frames are meant not to allocate once the game is warmed up (the
+ * bag, text formatting, batches and caches all reuse their storage), the
+ * counter is how that is checked: the frame timer records the allocations
+ * of every frame and bench fails if a warmed up frame allocates.
+ *
+ * Allocations made by SDL and the C library through malloc are not counted.
+ */
+
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+auto get_allocation_count () -> unsigned long;
+
+#endif /* ALLOC_COUNTER_H */
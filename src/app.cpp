@@ -7,17 +7,33 @@
  */
 
 #include "app.hpp"
+#include "alloc_counter.hpp"
+#include "asset_pack.hpp"
+#include "command_buffer.hpp"
+#include "frame_timer.hpp"
 #include "game.hpp"
-#include "renderer.hpp"
+#include "game_renderer.hpp"
+#include "input_latency.hpp"
+#include "input_queue.hpp"
+#include "music.hpp"
+#include "sdl_renderer.hpp"
+#include "replay.hpp"
+#include "startup_profiler.hpp"
+#include "trace.hpp"
+#include "triple_buffer.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#else
+#include <atomic>
+#include <thread>
 #endif
 
 using namespace application;
@@ -25,6 +41,13 @@ using namespace application;
 SDL_Window *g_window;
 renderer *g_renderer;
 game *g_game;
+game_renderer *g_game_renderer;
+replay_recorder *g_replay_recorder;
+replay_player *g_replay_player;
+frame_timer *g_frame_timer;
+static const char *replay_record_path = nullptr;
+static const char *frame_csv_path = nullptr;
+static const char *trace_path = nullptr;
 
 static bool is_done = false; /**< used to break the main event loop*/
 
@@ -33,6 +56,128 @@ static auto start_time
                                                      and calculate time for new
                                                      frame to be rendererd */
 
+using clock_duration = std::chrono::high_resolution_clock::duration;
+
+/** duration of one simulation step, the simulation runs at a fixed rate
+    whatever the refresh rate of the display */
+static constexpr clock_duration step_duration
+    = std::chrono::duration_cast<clock_duration> (std::chrono::seconds (1))
+      / game::steps_per_second;
+/** at most that many steps are simulated per frame, time beyond that is
+    dropped so a slow frame can't make the next ones slower (spiral of
+    death) */
+static constexpr auto max_steps_per_frame = 5;
+
+static clock_duration step_accumulator{}; /**< time not simulated yet */
+/** key presses and releases not consumed by a step yet, filled by the main
+    thread, consumed by the thread stepping the game */
+static input_queue g_input_queue;
+
+/** input latency measurement (--input-latency), null when off */
+static input_latency *g_input_latency = nullptr;
+static const char *input_latency_path = nullptr;
+
+#ifndef __EMSCRIPTEN__
+/**@brief a snapshot of the game and the time of the step that made it
+ */
+struct published_step
+{
+  game_snapshot snapshot;
+  std::chrono::steady_clock::time_point step_time;
+  uint32_t consumed_events; /**< see input_queue::get_consumed () */
+};
+
+/** simulation thread (--sim-thread): the game is stepped at its own rate on
+    a thread of its own and every step is published as a snapshot, the main
+    thread polls the events and draws the newest snapshot without waiting
+    for the simulation */
+static struct
+{
+  std::thread thread;
+  std::atomic<bool> stopping;
+  triple_buffer<published_step> *steps;
+  std::atomic<int> step_count; /**< steps since the last frame */
+} simulation;
+
+static void publish_step (std::chrono::steady_clock::time_point step_time);
+#endif
+
+/** every asset of the game, the font and the music are loaded from it in
+    the background while the game already runs. Without a pack they are
+    read from the loose files instead */
+static asset_pack g_assets;
+static constexpr auto asset_pack_path = "assets.pack";
+static constexpr auto font_path = "assets/clacon.ttf";
+
+/** background music (made with Bosca Ceoil https://boscaceoil.net/),
+    compressed track first. It isn't destroyed with the app: a download may
+    still complete after the main loop ended on the web */
+static background_music g_music;
+static const char *const music_paths[]
+    = { "assets/tetris.ogg", "assets/tetris.wav" };
+
+/** state of the asset pack, the music starts once both the pack and the
+    audio device are ready */
+enum class assets_state
+{
+  opening,
+  opened,
+  missing, // loose files are used
+};
+static assets_state assets = assets_state::opening;
+
+/** startup steps, only the ones needed by the first frame run before it.
+    The audio device is opened concurrently (on the web after the first
+    frame) and the diagnostics are printed after the first frame */
+static startup_profiler g_startup;
+static int first_frame_step = -1;
+static int font_step = -1;
+static int music_step = -1;
+static int audio_step = -1;
+static const char *startup_csv_path = nullptr;
+static bool quit_after_startup = false;
+
+static bool audio_ready = false;
+#ifndef __EMSCRIPTEN__
+static std::thread audio_thread;
+static std::atomic<bool> audio_thread_done (false);
+static bool audio_opened = false; // result of the thread, once it's done
+static startup_profiler::clock::time_point audio_end_time;
+#endif
+
+/** frame being recorded and last frame submitted, they are swapped after
+    every submission. A frame that would draw the same commands as the last
+    one isn't submitted, the window keeps showing it */
+static command_buffer frame_commands[2];
+static int recorded_frame = 0;
+static bool force_redraw = true; /**< the window contents were lost */
+
+/** steps and frames counted to report their rates once per second */
+static struct
+{
+  clock_duration elapsed;
+  int steps;
+  int frames;
+  int skipped_frames;
+} rate_counter = {};
+
+#ifndef NDEBUG
+static unsigned long frames_since_start = 0;
+static constexpr auto warm_up_frames = 120ul;
+#endif
+
+/** frame timing overlay, toggled with F3. Its text is only refreshed a few
+    times per second so that it stays readable and doesn't fill the text
+    cache of the renderer */
+static struct
+{
+  bool visible;
+  clock_duration since_refresh;
+  char lines[3][96];
+} frame_overlay = {};
+static constexpr clock_duration frame_overlay_refresh_period
+    = std::chrono::milliseconds (250);
+
 /** @brief Print SDL version info on stdout
  *
  *  @param Info that is to be printed before version info
@@ -51,39 +196,28 @@ operator== (SDL_version &a, SDL_version &b)
   return (a.major == b.major) && (a.minor == b.minor) && (a.patch == b.patch);
 }
 
-/** @brief check and initialise application
- *
- *  Initialise application by checking and initialising sdl, sdl windows, sdl
- *  renderer and sdl_ttf
+/** @brief Print what the assets loaded so far cost
  *
- *  @param width of the logical screen
- *  @param height of the logical screen
- *  @return true if the app was initialized properly, false otherwise
+ *  @return Void
  */
-bool
-application::init_app (const unsigned int width, const unsigned int height)
+static void
+report_asset_stats ()
 {
-  if (SDL_Init (SDL_INIT_VIDEO) != 0)
-    {
-      fprintf (stderr, "SDL failed to initialise: %s\n", SDL_GetError ());
-      return false;
-    }
-
-  printf ("SDL initialised\n");
-
-
-  // Initialize SDL video and audio systems
-  SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
-
-  // Initialize SDL mixer
-  Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-
-  // Load background music {made with Bosca Ceoil https://boscaceoil.net/}
-  Mix_Music *backgroundSound = Mix_LoadMUS("assets/tetris.wav");
-
-  // Start the background music
-  Mix_PlayMusic(backgroundSound, -1);
+  const auto &stats = g_assets.get_stats ();
+  printf ("Asset pack: %u assets loaded, %llu bytes fetched, %llu bytes "
+          "copied to the heap\n",
+          stats.loaded, static_cast<unsigned long long> (stats.fetched),
+          static_cast<unsigned long long> (stats.heap_bytes));
+}
 
+/** @brief Print the versions of the libraries, the displays and the render
+ *  drivers, once the first frame is presented
+ *
+ *  @return Void
+ */
+static void
+print_diagnostics ()
+{
   SDL_version compiled_version;
   SDL_version linked_version;
   SDL_VERSION (&compiled_version);
@@ -92,6 +226,11 @@ application::init_app (const unsigned int width, const unsigned int height)
   print_SDL_version ("Linking against SDL version", linked_version);
   SDL_assert_release ((compiled_version == linked_version));
 
+  SDL_TTF_VERSION (&compiled_version);
+  const SDL_version *linked_version_ptr = TTF_Linked_Version ();
+  print_SDL_version ("Compiled against SDL_ttf version", compiled_version);
+  print_SDL_version ("Linking against SDL_ttf version", *linked_version_ptr);
+
   int num_displays = SDL_GetNumVideoDisplays ();
   printf ("%d video displays\n", num_displays);
   for (int i = 0; i < num_displays; ++i)
@@ -109,6 +248,188 @@ application::init_app (const unsigned int width, const unsigned int height)
               display_mode.h, display_mode.refresh_rate);
     }
 
+  sdl_renderer::print_render_drivers ();
+}
+
+/** @brief Play the music once both the audio device and the assets are
+ *  ready
+ *
+ *  @return Void
+ */
+static void
+start_music ()
+{
+  if (!audio_ready || assets == assets_state::opening)
+    return;
+
+  music_step = g_startup.begin_step ("music");
+  if (assets == assets_state::missing)
+    {
+      g_music.start (music_paths,
+                     sizeof (music_paths) / sizeof (*music_paths));
+      g_startup.end_step (music_step);
+      return;
+    }
+
+  for (const auto path : music_paths)
+    {
+      const auto music = g_assets.find (path);
+      if (music == invalid_asset)
+        continue;
+      g_assets.load (music, [path] (const uint8_t *data, std::size_t size) {
+        if (data)
+          g_music.start (path, data, size);
+        g_startup.end_step (music_step);
+        report_asset_stats ();
+      });
+      return;
+    }
+  g_startup.end_step (music_step);
+}
+
+/** @brief Open the audio device, SDL_mixer and its OGG decoder
+ *
+ *  @return true if music can be played, false otherwise
+ */
+static bool
+open_audio ()
+{
+  TRACE_ZONE ("open_audio");
+  // the game runs without music if there is no audio device
+  if (SDL_InitSubSystem (SDL_INIT_AUDIO) != 0
+      || Mix_OpenAudio (44100, MIX_DEFAULT_FORMAT, 2, 2048) != 0)
+    {
+      fprintf (stderr, "Failed to initialise audio: %s\n", SDL_GetError ());
+      return false;
+    }
+  if (!(Mix_Init (MIX_INIT_OGG) & MIX_INIT_OGG))
+    fprintf (stderr, "No OGG support: %s\n", Mix_GetError ());
+  return true;
+}
+
+/** @brief Start opening the audio device, without waiting for it
+ *
+ *  Opening the device can take a while (connecting to the sound server), so
+ *  native builds open it on a thread of their own while the window and the
+ *  first frame are made. Only audio functions are called on that thread and
+ *  the main thread initialises no other SDL subsystem meanwhile. Web builds
+ *  have no threads, they open it after the first frame.
+ *
+ *  @return Void
+ */
+static void
+start_audio ()
+{
+  audio_step = g_startup.begin_step ("audio");
+#ifdef __EMSCRIPTEN__
+  audio_ready = open_audio ();
+  g_startup.end_step (audio_step);
+  start_music ();
+#else
+  audio_thread = std::thread ([] {
+    set_trace_thread_name ("audio");
+    audio_opened = open_audio ();
+    audio_end_time = startup_profiler::clock::now ();
+    audio_thread_done.store (true, std::memory_order_release);
+  });
+#endif
+}
+
+/** @brief Check if the audio device was opened, the music starts then
+ *
+ *  @return Void
+ */
+static void
+poll_audio ()
+{
+#ifndef __EMSCRIPTEN__
+  if (!audio_thread.joinable ()
+      || !audio_thread_done.load (std::memory_order_acquire))
+    return;
+  audio_thread.join ();
+  audio_ready = audio_opened;
+  g_startup.end_step (audio_step, audio_end_time);
+  start_music ();
+#endif
+}
+
+/** @brief Use the font once it is loaded, the title screen is drawn again
+ *
+ *  @param data of the font, null if it could not be loaded
+ *  @param size of the data
+ *  @return Void
+ */
+static void
+on_font_loaded (const uint8_t *data, std::size_t size)
+{
+  // the window renderer is the only one the app creates
+  auto &window_renderer = static_cast<sdl_renderer &> (*g_renderer);
+  if (data
+      && window_renderer.load_font (
+          SDL_RWFromConstMem (data, static_cast<int> (size))))
+    force_redraw = true;
+  g_startup.end_step (font_step);
+  report_asset_stats ();
+}
+
+/** @brief Load the font and the music from the pack once it is open, from
+ *  the loose files if it couldn't be opened
+ *
+ *  @param opened true if the pack was opened
+ *  @return Void
+ */
+static void
+on_assets_opened (bool opened)
+{
+  font_step = g_startup.begin_step ("font");
+  if (opened)
+    {
+      assets = assets_state::opened;
+      g_assets.load (g_assets.find (font_path), on_font_loaded);
+    }
+  else
+    {
+      assets = assets_state::missing;
+      auto &window_renderer = static_cast<sdl_renderer &> (*g_renderer);
+      if (window_renderer.load_font (SDL_RWFromFile (font_path, "rb")))
+        force_redraw = true;
+      g_startup.end_step (font_step);
+    }
+  start_music ();
+}
+
+/** @brief check and initialise application
+ *
+ *  Initialise application by checking and initialising sdl, sdl windows, sdl
+ *  renderer and sdl_ttf
+ *
+ *  @param width of the logical screen
+ *  @param height of the logical screen
+ *  @param options given on the command line
+ *  @return true if the app was initialized properly, false otherwise
+ */
+bool
+application::init_app (const unsigned int width, const unsigned int height,
+                       const app_options &options)
+{
+  set_trace_thread_name ("main");
+  startup_csv_path = options.startup_csv_path;
+  quit_after_startup = options.quit_after_startup;
+
+  auto step = g_startup.begin_step ("SDL video");
+  if (SDL_Init (SDL_INIT_VIDEO) != 0)
+    {
+      fprintf (stderr, "SDL failed to initialise: %s\n", SDL_GetError ());
+      return false;
+    }
+  g_startup.end_step (step);
+
+  printf ("SDL initialised\n");
+#ifndef __EMSCRIPTEN__
+  start_audio ();
+#endif
+
+  step = g_startup.begin_step ("window");
   const char *title = "Tetris";
   g_window = SDL_CreateWindow (title, SDL_WINDOWPOS_UNDEFINED,
                                SDL_WINDOWPOS_UNDEFINED, width, height,
@@ -119,37 +440,146 @@ application::init_app (const unsigned int width, const unsigned int height)
       printf ("Failed to create SDL window: %s\n", SDL_GetError ());
       return false;
     }
+  g_startup.end_step (step);
 
   // SDL2_ttf
 
+  step = g_startup.begin_step ("SDL_ttf");
   if (TTF_Init () == -1)
     {
       fprintf (stderr, "Failed to initialise SDL2_ttf: %s\n", TTF_GetError ());
       return false;
     }
+  g_startup.end_step (step);
 
   printf ("SDL_ttf initialised\n");
 
-  SDL_TTF_VERSION (&compiled_version);
-  const SDL_version *linked_version_ptr = TTF_Linked_Version ();
-  print_SDL_version ("Compiled against SDL_ttf version", compiled_version);
-  print_SDL_version ("Linking against SDL_ttf version", *linked_version_ptr);
-
+  step = g_startup.begin_step ("renderer");
   unsigned int logicalWidth = 1280;
   unsigned int logicalHeight = 720;
-  g_renderer = new renderer (*g_window, logicalWidth, logicalHeight);
+  g_renderer = new sdl_renderer (*g_window, logicalWidth, logicalHeight);
+  g_startup.end_step (step);
+
+  step = g_startup.begin_step ("game");
+  auto seed = options.seed;
+  if (options.replay_path)
+    {
+      std::vector<uint8_t> replay_data;
+      g_replay_player = new replay_player ();
+      if (!read_replay_file (options.replay_path, replay_data)
+          || !g_replay_player->load (replay_data))
+        {
+          fprintf (stderr, "Failed to load replay %s\n", options.replay_path);
+          return false;
+        }
+      seed = g_replay_player->get_seed ();
+    }
+  if (options.record_path)
+    {
+      g_replay_recorder = new replay_recorder (seed);
+      replay_record_path = options.record_path;
+    }
 
-  g_game = new game ();
+  g_game = new game (seed);
+  g_game_renderer = new game_renderer ();
+  g_frame_timer = new frame_timer ();
+  frame_csv_path = options.frame_csv_path;
+  trace_path = options.trace_path;
+  g_input_queue.set_handling (options.handling);
+  if (options.input_latency_path)
+    {
+      g_input_latency = new input_latency ();
+      input_latency_path = options.input_latency_path;
+    }
 
   if (!g_game->init_game ())
     {
       fprintf (stderr, "ERROR - Game failed to initialise\n");
       return false;
     }
+  g_startup.end_step (step);
+
+  // the font and the music are loaded while the first frames are drawn
+  step = g_startup.begin_step ("asset pack");
+  g_assets.open (asset_pack_path, on_assets_opened);
+  g_startup.end_step (step);
+
+#ifndef __EMSCRIPTEN__
+  // the first frame draws a snapshot published before the thread starts
+  if (options.sim_thread)
+    {
+      simulation.steps = new triple_buffer<published_step> ();
+      publish_step (std::chrono::steady_clock::now ());
+    }
+#endif
 
   return true;
 }
 
+/** @brief Time of a key event on the clock of the input queue
+ *
+ *  SDL stamps the events in milliseconds of SDL_GetTicks (), the time is
+ *  brought to the steady clock through the time elapsed since.
+ *
+ *  @param key event
+ *  @return time of the event
+ */
+static input_queue::clock::time_point
+key_event_time (const SDL_KeyboardEvent &key)
+{
+  const auto now = input_queue::clock::now ();
+  const auto age = static_cast<int32_t> (SDL_GetTicks () - key.timestamp);
+  return now - std::chrono::milliseconds (std::max (age, 0));
+}
+
+/** @brief Queue the press or release of a button for the simulation
+ *
+ *  Presses of move, rotate and drop buttons are followed by the input
+ *  latency measurement, when it is on.
+ *
+ *  @param button of the key
+ *  @param key event of the press or release
+ *  @return Void
+ */
+static void
+queue_key (input_button button, const SDL_KeyboardEvent &key)
+{
+  const auto pressed = key.type == SDL_KEYDOWN;
+  const auto time = key_event_time (key);
+  if (!g_input_queue.push (button, pressed, time))
+    {
+      fprintf (stderr, "Input queue full, key %s dropped\n",
+               SDL_GetKeyName (key.keysym.sym));
+      return;
+    }
+  if (!g_input_latency || !pressed)
+    return;
+
+  auto kind = input_kind::count;
+  switch (button)
+    {
+    case input_button::move_left:
+    case input_button::move_right:
+      kind = input_kind::move;
+      break;
+    case input_button::rotate_clockwise:
+    case input_button::rotate_anticlockwise:
+      kind = input_kind::rotate;
+      break;
+    case input_button::soft_drop:
+      kind = input_kind::soft_drop;
+      break;
+    case input_button::hard_drop:
+      kind = input_kind::hard_drop;
+      break;
+    default:
+      return;
+    }
+  // the event is the latest pushed, its number tells when a step took it
+  g_input_latency->on_event (kind, time, input_queue::clock::now (),
+                             g_input_queue.get_pushed ());
+}
+
 /** @brief process the keypress of the user
  *
  *  process and translate the keypresses by the user to corresponding input to
@@ -166,13 +596,16 @@ application::init_app (const unsigned int width, const unsigned int height)
  *  space        -> hard drop
  *  down_arrow   -> soft drop
  *  p            -> pause game
+ *  f3           -> show/hide frame timings
+ *
+ *  Game buttons are queued with the time they were pressed and released,
+ *  the simulation turns them into the input of its steps. Held buttons
+ *  repeat there, the key repeat of the OS is ignored.
  *
- *  @param reference of game input object that needs to be updated with
- *  processed info
  *  @return Void
  */
 static void
-process_input (game_input &input)
+process_input ()
 {
   SDL_Event event;
   while (SDL_PollEvent (&event))
@@ -182,46 +615,217 @@ process_input (game_input &input)
           is_done = true;
         }
 
-      // quit if escape pressed
-      if (event.type == SDL_KEYDOWN)
+      // contents of render target textures (or all textures) are gone
+      if (event.type == SDL_RENDER_TARGETS_RESET
+          || event.type == SDL_RENDER_DEVICE_RESET)
         {
-          switch (event.key.keysym.sym)
+          g_renderer->on_render_reset (event.type
+                                       == SDL_RENDER_DEVICE_RESET);
+          force_redraw = true;
+        }
+
+      // the window has to be drawn again even if the frame didn't change
+      if (event.type == SDL_WINDOWEVENT)
+        force_redraw = true;
+
+      if ((event.type != SDL_KEYDOWN && event.type != SDL_KEYUP)
+          || event.key.repeat)
+        continue;
+
+      const auto pressed = event.type == SDL_KEYDOWN;
+      switch (event.key.keysym.sym)
+        {
+        // quit if escape pressed
+        case SDLK_ESCAPE:
+        case SDLK_q:
+          if (pressed)
+            is_done = true;
+          break;
+        case SDLK_RETURN:
+          queue_key (input_button::start, event.key);
+          break;
+        case SDLK_LEFT:
+          queue_key (input_button::move_left, event.key);
+          break;
+        case SDLK_RIGHT:
+          queue_key (input_button::move_right, event.key);
+          break;
+        case SDLK_z:
+        case SDLK_UP:
+          queue_key (input_button::rotate_clockwise, event.key);
+          break;
+        case SDLK_x:
+        case SDLK_LCTRL:
+          queue_key (input_button::rotate_anticlockwise, event.key);
+          break;
+        case SDLK_DOWN:
+          queue_key (input_button::soft_drop, event.key);
+          break;
+        case SDLK_p:
+          queue_key (input_button::pause, event.key);
+          break;
+        case SDLK_r:
+          queue_key (input_button::reset, event.key);
+          break;
+        case SDLK_SPACE:
+          queue_key (input_button::hard_drop, event.key);
+          break;
+        case SDLK_F3:
+          if (pressed)
             {
-            case SDLK_ESCAPE:
-            case SDLK_q:
-              is_done = true;
-              break;
-            case SDLK_RETURN:
-              input.m_start = true;
-              break;
-            case SDLK_LEFT:
-              input.m_move_left = true;
-              break;
-            case SDLK_RIGHT:
-              input.m_move_right = true;
-              break;
-            case SDLK_z:
-            case SDLK_UP:
-              input.m_rotate_clockwise = true;
-              break;
-            case SDLK_x:
-            case SDLK_LCTRL:
-              input.m_rotate_anticlockwise = true;
-              break;
-            case SDLK_DOWN:
-              input.m_soft_drop = true;
-              break;
-            case SDLK_p:
-              input.m_pause = true;
-              break;
-            case SDLK_r:
-              input.m_reset = true;
-              break;
-            case SDLK_SPACE:
-              input.m_hard_drop = true;
-              break;
+              frame_overlay.visible = !frame_overlay.visible;
+              frame_overlay.since_refresh = frame_overlay_refresh_period;
             }
+          break;
+        }
+    }
+}
+
+/** @brief Run a single step of the game
+ *
+ *  Recorded inputs replace the given one while a replay is played, every
+ *  input is recorded when recording.
+ *
+ *  @param input of the step
+ *  @return Void
+ */
+static void
+run_step (game_input input)
+{
+  // recorded inputs replace the keyboard until the replay is over
+  if (g_replay_player && !g_replay_player->next (input))
+    {
+      printf ("Replay over, state %s the recorded one\n",
+              g_replay_player->matches (*g_game) ? "matches"
+                                                 : "differs from");
+      delete g_replay_player;
+      g_replay_player = nullptr;
+    }
+
+  if (g_replay_recorder)
+    g_replay_recorder->record (input);
+  {
+    TRACE_ZONE ("game::step");
+    g_game->step (input);
+  }
+  if (g_replay_recorder)
+    g_replay_recorder->record_state (*g_game);
+  if (g_replay_player && !g_replay_player->check (*g_game))
+    {
+      fprintf (stderr, "Replay diverged from the recording at step %llu\n",
+               static_cast<unsigned long long> (
+                   g_replay_player->get_divergent_step ()));
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+/** @brief Publish a snapshot of the game for the main thread
+ *
+ *  @param time of the last step
+ *  @return Void
+ */
+static void
+publish_step (std::chrono::steady_clock::time_point step_time)
+{
+  auto &published = simulation.steps->get_write_slot ();
+  g_game->take_snapshot (published.snapshot);
+  published.step_time = step_time;
+  published.consumed_events = g_input_queue.get_consumed ();
+  simulation.steps->publish ();
+}
+
+/** @brief Step the game at a fixed rate until the simulation is stopped
+ *
+ *  Runs on the simulation thread, which owns the game (and the replay
+ *  recorder and player) until it is stopped.
+ *
+ *  @return Void
+ */
+static void
+simulation_loop ()
+{
+  set_trace_thread_name ("simulation");
+  auto next_step = std::chrono::steady_clock::now () + step_duration;
+  while (!simulation.stopping.load (std::memory_order_relaxed))
+    {
+      std::this_thread::sleep_until (next_step);
+      const auto now = std::chrono::steady_clock::now ();
+
+      auto steps = 0;
+      while (next_step <= now && steps < max_steps_per_frame)
+        {
+          run_step (g_input_queue.next_step (next_step));
+          next_step += step_duration;
+          ++steps;
         }
+      // time beyond max_steps_per_frame steps is dropped
+      if (next_step <= now)
+        next_step = now + step_duration;
+
+      simulation.step_count.fetch_add (steps, std::memory_order_relaxed);
+      publish_step (next_step - step_duration);
+    }
+}
+
+/** @brief Stop the simulation thread, the game belongs to the main thread
+ *  again
+ *
+ *  @return Void
+ */
+static void
+stop_simulation ()
+{
+  if (!simulation.thread.joinable ())
+    return;
+  simulation.stopping = true;
+  simulation.thread.join ();
+  delete simulation.steps;
+  simulation.steps = nullptr;
+}
+#endif
+
+/** @brief Draw the frame timings over the game
+ *
+ *  Shows the frame rate, median and 99th percentile frame times and the
+ *  average time of every phase over the frames kept by the frame timer.
+ *
+ *  @param command buffer of the frame
+ *  @param time elapsed since the previous frame
+ *  @return Void
+ */
+static void
+draw_frame_overlay (command_buffer &commands, clock_duration delta_time)
+{
+  frame_overlay.since_refresh += delta_time;
+  if (frame_overlay.since_refresh >= frame_overlay_refresh_period)
+    {
+      frame_overlay.since_refresh = {};
+      const auto summary = g_frame_timer->summarize ();
+      const auto *phase_ms = summary.phase_ms;
+      snprintf (frame_overlay.lines[0], sizeof (frame_overlay.lines[0]),
+                "%.0f fps  p50 %.2f ms  p99 %.2f ms  max %.2f ms",
+                summary.fps, summary.p50_ms, summary.p99_ms, summary.max_ms);
+      snprintf (frame_overlay.lines[1], sizeof (frame_overlay.lines[1]),
+                "input %.2f  update %.2f  draw %.2f  present %.2f ms",
+                phase_ms[static_cast<int> (frame_phase::input)],
+                phase_ms[static_cast<int> (frame_phase::update)],
+                phase_ms[static_cast<int> (frame_phase::draw)],
+                phase_ms[static_cast<int> (frame_phase::present)]);
+      snprintf (frame_overlay.lines[2], sizeof (frame_overlay.lines[2]),
+                "over the last %u frames, max %u allocs/frame",
+                summary.frame_num,
+                static_cast<unsigned int> (summary.max_allocations));
+    }
+
+  // above everything the game draws
+  constexpr unsigned char background_depth = game_renderer::top_depth + 1;
+  constexpr unsigned char text_depth = game_renderer::top_depth + 2;
+  commands.draw_filled_rectangle (background_depth, coords (0, 0), 760, 110,
+                                  0x000000c0);
+  for (auto i = 0; i < 3; ++i)
+    {
+      commands.draw_text (text_depth, frame_overlay.lines[i],
+                          coords (10, 5 + i * 35), 0xffff00ff);
     }
 }
 
@@ -242,26 +846,167 @@ event_loop_handler ()
     {
       emscripten_cancel_main_loop ();
       shut_down_app ();
+      // lets emrun --kill_exit end the browser of a startup measurement
+      if (quit_after_startup)
+        emscripten_force_exit (0);
+      return;
     }
 
 #endif
 
-  game_input input = {};
-  process_input (input);
+  TRACE_ZONE ("frame");
+  g_frame_timer->begin_frame ();
+  const auto allocations_at_start = get_allocation_count ();
+
+  g_assets.poll ();
+  poll_audio ();
+  if (quit_after_startup && g_startup.is_done ())
+    is_done = true;
+  // key presses are queued until a step consumes them, so none are lost when
+  // frames are shorter (or longer) than steps
+  process_input ();
+  const auto poll_time = input_queue::clock::now ();
+  g_frame_timer->end_phase (frame_phase::input);
 
   auto current_time = std::chrono::high_resolution_clock::now ();
   auto delta_time = current_time - start_time;
-  auto delta_time_microsec
-      = std::chrono::duration_cast<std::chrono::microseconds> (delta_time);
-  auto delta_time_seconds
-      = 0.000001f * static_cast<float> (delta_time_microsec.count ());
   start_time = current_time;
 
-  g_game->update (input, delta_time_seconds);
+  auto steps = 0;
+  game_view view;
+  clock_duration since_step; // time elapsed since the last step
+#ifndef __EMSCRIPTEN__
+  if (simulation.steps)
+    {
+      // draw the newest step of the simulation thread
+      steps = simulation.step_count.exchange (0, std::memory_order_relaxed);
+      simulation.steps->acquire ();
+      const auto &published = simulation.steps->get_read_slot ();
+      view = published.snapshot.m_view;
+      if (g_input_latency)
+        g_input_latency->on_consumed (published.consumed_events,
+                                      published.step_time);
+      since_step = std::chrono::duration_cast<clock_duration> (
+          std::chrono::steady_clock::now () - published.step_time);
+      since_step = std::min (since_step, step_duration - clock_duration (1));
+    }
+  else
+#endif
+    {
+      step_accumulator += delta_time;
+      if (step_accumulator > max_steps_per_frame * step_duration)
+        step_accumulator = max_steps_per_frame * step_duration;
+
+      // the time not simulated yet starts there
+      using queue_duration = input_queue::clock::duration;
+      auto step_end = poll_time
+                      - std::chrono::duration_cast<queue_duration> (
+                          step_accumulator);
+      while (step_accumulator >= step_duration)
+        {
+          step_accumulator -= step_duration;
+          step_end += step_duration;
+          ++steps;
+
+          // every step takes the key events of its time span, the last one
+          // of the frame also those polled since, they don't wait a frame
+          run_step (g_input_queue.next_step (
+              step_accumulator >= step_duration ? step_end : poll_time));
+          if (g_input_latency)
+            g_input_latency->on_consumed (g_input_queue.get_consumed (),
+                                          input_latency::clock::now ());
+        }
+      view = g_game->view ();
+      since_step = step_accumulator;
+    }
+  g_frame_timer->set_steps (steps);
+  g_frame_timer->end_phase (frame_phase::update);
+
+  // fraction of the next step already elapsed, used to smooth movement
+  const auto interpolation = std::chrono::duration<float> (since_step)
+                             / std::chrono::duration<float> (step_duration);
 
-  g_renderer->clear ();
-  g_game->draw (*g_renderer);
-  g_renderer->present ();
+  auto &commands = frame_commands[recorded_frame];
+  commands.clear ();
+  g_game_renderer->draw (*g_renderer, commands, view, interpolation);
+  if (frame_overlay.visible)
+    draw_frame_overlay (commands, delta_time);
+  const auto skip_frame
+      = !force_redraw && commands.is_same (frame_commands[1 - recorded_frame]);
+  if (!skip_frame)
+    {
+      g_renderer->clear ();
+      commands.submit (*g_renderer);
+    }
+  g_frame_timer->end_phase (frame_phase::draw);
+  if (!skip_frame)
+    g_renderer->present ();
+  // the result of the consumed inputs is on screen now (already was if the
+  // frame is unchanged)
+  if (g_input_latency)
+    g_input_latency->on_presented (input_latency::clock::now ());
+  if (!skip_frame)
+    {
+      recorded_frame = 1 - recorded_frame;
+      force_redraw = false;
+      if (g_startup.get_first_frame_ms () <= 0)
+        {
+          g_startup.end_step (first_frame_step);
+          g_startup.first_frame_presented ();
+
+          // startup work the first frame didn't need
+          const auto step = g_startup.begin_step ("diagnostics");
+          print_diagnostics ();
+          g_startup.end_step (step);
+#ifdef __EMSCRIPTEN__
+          start_audio ();
+#endif
+        }
+    }
+  g_frame_timer->end_phase (frame_phase::present);
+#ifndef __EMSCRIPTEN__
+  if (skip_frame)
+    {
+      // no vsync to wait for, sleep until the next step may change the frame.
+      // The sleep is outside of the phases, only the frame time counts it
+      const auto until_next_step
+          = std::chrono::duration_cast<std::chrono::milliseconds> (
+              step_duration - since_step);
+      SDL_Delay (std::max<Uint32> (1, until_next_step.count ()));
+    }
+#endif
+
+  const auto allocations = get_allocation_count () - allocations_at_start;
+  g_frame_timer->set_allocations (static_cast<uint32_t> (allocations));
+#ifndef NDEBUG
+  // once warmed up, frames are meant not to allocate (the replay recorder
+  // grows its buffer, it is left out)
+  ++frames_since_start;
+  if (allocations && frames_since_start > warm_up_frames
+      && !g_replay_recorder)
+    {
+      fprintf (stderr, "Frame %lu made %lu heap allocations\n",
+               frames_since_start, allocations);
+    }
+#endif
+
+  // report simulation and render rates separately
+  rate_counter.elapsed += delta_time;
+  rate_counter.steps += steps;
+  ++rate_counter.frames;
+  rate_counter.skipped_frames += skip_frame;
+  if (rate_counter.elapsed >= std::chrono::seconds (1))
+    {
+      const auto seconds
+          = std::chrono::duration<double> (rate_counter.elapsed).count ();
+      char title[96];
+      snprintf (title, sizeof (title),
+                "Tetris - %.0f steps/s, %.0f fps (%.0f unchanged)",
+                rate_counter.steps / seconds, rate_counter.frames / seconds,
+                rate_counter.skipped_frames / seconds);
+      SDL_SetWindowTitle (g_window, title);
+      rate_counter = {};
+    }
 }
 
 /** @brief Run the application main loop
@@ -283,7 +1028,14 @@ void
 application::run_app ()
 {
   start_time = std::chrono::high_resolution_clock::now ();
+  step_accumulator = {};
   is_done = false;
+  first_frame_step = g_startup.begin_step ("first frame");
+
+#ifndef __EMSCRIPTEN__
+  if (simulation.steps)
+    simulation.thread = std::thread (simulation_loop);
+#endif
 
 #ifdef __EMSCRIPTEN__
   emscripten_set_main_loop (event_loop_handler, -1, 0);
@@ -298,6 +1050,60 @@ application::run_app ()
 void
 application::shut_down_app ()
 {
+#ifndef __EMSCRIPTEN__
+  stop_simulation ();
+#endif
+
+  if (g_replay_recorder && g_game)
+    {
+      const auto &replay_data = g_replay_recorder->finish (*g_game);
+      if (write_replay_file (replay_record_path, replay_data))
+        printf ("Replay saved to %s (%zu bytes)\n", replay_record_path,
+                replay_data.size ());
+      else
+        fprintf (stderr, "Failed to save replay to %s\n", replay_record_path);
+    }
+  delete g_replay_recorder;
+  g_replay_recorder = nullptr;
+  delete g_replay_player;
+  g_replay_player = nullptr;
+
+  if (g_frame_timer && frame_csv_path)
+    {
+      if (g_frame_timer->write_csv (frame_csv_path))
+        printf ("Frame timings saved to %s\n", frame_csv_path);
+      else
+        fprintf (stderr, "Failed to save frame timings to %s\n",
+                 frame_csv_path);
+    }
+  delete g_frame_timer;
+  g_frame_timer = nullptr;
+
+  if (g_input_latency)
+    {
+      g_input_latency->print ();
+      if (g_input_latency->write_csv (input_latency_path))
+        printf ("Input latency histograms saved to %s\n",
+                input_latency_path);
+      else
+        fprintf (stderr, "Failed to save input latency histograms to %s\n",
+                 input_latency_path);
+    }
+  delete g_input_latency;
+  g_input_latency = nullptr;
+
+  if (trace_path && write_trace_file (trace_path))
+    printf ("Trace saved to %s\n", trace_path);
+
+  if (startup_csv_path)
+    {
+      if (g_startup.append_csv (startup_csv_path))
+        printf ("Startup timings appended to %s\n", startup_csv_path);
+      else
+        fprintf (stderr, "Failed to save startup timings to %s\n",
+                 startup_csv_path);
+    }
+
   if (g_game)
     {
       g_game->shutdown ();
@@ -305,9 +1111,23 @@ application::shut_down_app ()
       g_game = nullptr;
     }
 
+  delete g_game_renderer;
+  g_game_renderer = nullptr;
+
   delete g_renderer;
   g_renderer = nullptr;
 
+  // the font and the music were read from the pack
+  g_music.stop ();
+  g_assets.close ();
+
+#ifndef __EMSCRIPTEN__
+  if (audio_thread.joinable ())
+    audio_thread.join ();
+#endif
+  Mix_CloseAudio ();
+  Mix_Quit ();
+
   TTF_Quit ();
   SDL_DestroyWindow (g_window);
   SDL_Quit ();
@@ -9,16 +9,44 @@
 #ifndef EM_APP_H
 #define EM_APP_H
 
+#include "input_queue.hpp"
+#include <cstdint>
+
 namespace application
 {
 
+/**@brief command line options of the application
+ */
+struct app_options
+{
+  uint64_t seed;           /**< seed of the game */
+  const char *record_path; /**< file the inputs are recorded to, or null */
+  const char *replay_path; /**< replay to be played back, or null */
+  const char *frame_csv_path; /**< file the frame timings are saved to on
+                                   exit, or null */
+  const char *trace_path; /**< file the trace zones are saved to on exit, or
+                               null */
+  bool sim_thread; /**< step the game on a thread of its own, ignored by
+                       web builds */
+  const char *startup_csv_path; /**< file the startup timings are appended
+                                     to on exit, or null */
+  bool quit_after_startup; /**< exit once the first frame is presented and
+                                everything deferred is loaded */
+  const char *input_latency_path; /**< measure the input latency and save
+                                       its histograms to this file on exit,
+                                       or null */
+  input_handling handling; /**< how held moves and soft drops repeat */
+};
+
 /**@brief check and initialize the application
  *
  * @param width of the logical screen
  * @param height of the logical screen
+ * @param options given on the command line
  * @return true if the app was initialized properly, false otherwise
  */
-bool init_app (const unsigned int width, const unsigned int height);
+bool init_app (const unsigned int width, const unsigned int height,
+               const app_options &options);
 
 /**@brief launch the aplication and main loop
  *
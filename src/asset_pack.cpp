@@ -0,0 +1,621 @@
+/**@file asset_pack.cpp
+ * @brief contains functions that read, load and write asset packs.
+ *
+ */
+
+#include "asset_pack.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char pack_magic[4] = { 'T', 'P', 'A', 'K' };
+static constexpr uint32_t pack_version = 1;
+
+/**@brief read a little endian integer of the given number of bytes
+ */
+static auto
+read_le (const uint8_t *data, unsigned int bytes) -> uint64_t
+{
+  uint64_t value = 0;
+  for (auto i = 0u; i < bytes; ++i)
+    value |= static_cast<uint64_t> (data[i]) << (i * 8);
+  return value;
+}
+
+/**@brief append a little endian integer of the given number of bytes
+ */
+static auto
+write_le (std::vector<uint8_t> &data, unsigned int bytes, uint64_t value)
+    -> void
+{
+  for (auto i = 0u; i < bytes; ++i)
+    data.push_back (static_cast<uint8_t> (value >> (i * 8)));
+}
+
+#ifdef __EMSCRIPTEN__
+enum class fetch_stage
+{
+  header,
+  index,
+  asset,
+};
+
+/**@brief a range request in flight
+ */
+struct asset_pack::fetch_request
+{
+  asset_pack *pack;
+  unsigned int generation;
+  fetch_stage stage;
+  asset_handle asset;
+  uint32_t asset_num; // of the index being downloaded
+  uint64_t offset;
+  uint64_t size;
+  load_callback on_load;
+};
+#endif
+
+/**@brief Constructor of asset_pack class
+ */
+asset_pack::asset_pack ()
+    : m_path (), m_generation (0), m_open (false), m_on_open (), m_assets (),
+      m_stats (),
+#ifndef __EMSCRIPTEN__
+      m_mapping (nullptr), m_mapping_size (0), m_loader (),
+      m_stopping (false), m_requests (),
+#endif
+      m_mutex (), m_wake (), m_completed (), m_running ()
+{
+}
+
+/**@brief Destructor of asset_pack class
+ */
+asset_pack::~asset_pack () { close (); }
+
+/**@brief Open a pack, on_open is called by poll () once it is open (or
+ * failed to)
+ *
+ * Native builds map the pack and read its index right away, web builds
+ * download its header and index with two range requests.
+ *
+ * @param path (or URL) of the pack
+ * @param on_open called with true if the pack was opened
+ * @return void
+ */
+auto
+asset_pack::open (const char *path, open_callback on_open) -> void
+{
+  close ();
+  m_path = path;
+  m_on_open = std::move (on_open);
+
+#ifdef __EMSCRIPTEN__
+  fetch_range (0, header_size,
+               new fetch_request{ this, m_generation, fetch_stage::header,
+                                  invalid_asset, 0, 0, 0, nullptr });
+#else
+  TRACE_ZONE ("asset_pack::open");
+  const auto file = ::open (path, O_RDONLY);
+  struct stat info;
+  if (file >= 0 && fstat (file, &info) == 0
+      && static_cast<std::size_t> (info.st_size) >= header_size)
+    {
+      const auto size = static_cast<std::size_t> (info.st_size);
+      auto *mapping = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+      if (mapping != MAP_FAILED)
+        {
+          m_mapping = static_cast<const uint8_t *> (mapping);
+          m_mapping_size = size;
+        }
+    }
+  if (file >= 0)
+    ::close (file);
+
+  uint32_t index_size = 0, asset_num = 0;
+  m_open = m_mapping
+           && read_header (m_mapping, m_mapping_size, index_size, asset_num)
+           && index_size <= m_mapping_size - header_size
+           && read_index (m_mapping + header_size, index_size, asset_num,
+                          m_mapping_size);
+  if (m_open)
+    {
+      m_stopping = false;
+      m_loader = std::thread (&asset_pack::loader_loop, this);
+    }
+  else
+    {
+      fprintf (stderr, "Failed to open asset pack %s\n", path);
+      close ();
+    }
+  complete ({ true, invalid_asset, m_open, nullptr });
+#endif
+}
+
+/**@brief Close the pack, the data of its assets is gone and the callbacks
+ * not run yet are dropped
+ *
+ * @return void
+ */
+auto
+asset_pack::close () -> void
+{
+#ifdef __EMSCRIPTEN__
+  // fetches in flight can't be cancelled, they are ignored when they end
+  m_pack_data.clear ();
+  m_pack_data.shrink_to_fit ();
+#else
+  if (m_loader.joinable ())
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_stopping = true;
+      }
+      m_wake.notify_one ();
+      m_loader.join ();
+    }
+  m_requests.clear ();
+  if (m_mapping)
+    munmap (const_cast<uint8_t *> (m_mapping), m_mapping_size);
+  m_mapping = nullptr;
+  m_mapping_size = 0;
+#endif
+
+  ++m_generation;
+  m_open = false;
+  m_assets.clear ();
+  m_completed.clear ();
+  m_stats = {};
+}
+
+/**@brief Find an asset of the pack
+ *
+ * @param name of the asset, the path it was packed from
+ * @return handle of the asset, invalid_asset if the pack doesn't have it
+ */
+auto
+asset_pack::find (const char *name) const -> asset_handle
+{
+  for (auto i = 0u; i < m_assets.size (); ++i)
+    {
+      if (m_assets[i].name == name)
+        return static_cast<asset_handle> (i);
+    }
+  return invalid_asset;
+}
+
+/**@brief Load an asset in the background, on_load is called by poll () once
+ * it is loaded
+ *
+ * @param handle of the asset
+ * @param on_load called with the data of the asset, or null if it could not
+ * be loaded
+ * @return void
+ */
+auto
+asset_pack::load (asset_handle asset, load_callback on_load) -> void
+{
+  if (!m_open || asset < 0 || asset >= static_cast<int> (m_assets.size ()))
+    {
+      complete ({ false, asset, false, std::move (on_load) });
+      return;
+    }
+
+#ifdef __EMSCRIPTEN__
+  const auto &entry = m_assets[asset];
+  if (!m_pack_data.empty () || entry.size == 0)
+    {
+      // the whole pack may have come after the index was checked
+      const auto in_pack
+          = entry.offset + entry.size <= m_pack_data.size ();
+      complete ({ false, asset, entry.size == 0 || in_pack,
+                  std::move (on_load) });
+      return;
+    }
+  fetch_range (entry.offset, entry.size,
+               new fetch_request{ this, m_generation, fetch_stage::asset,
+                                  asset, 0, 0, 0, std::move (on_load) });
+#else
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_requests.push_back ({ false, asset, true, std::move (on_load) });
+  }
+  m_wake.notify_one ();
+#endif
+}
+
+/**@brief Run the callbacks of the assets loaded since the last call
+ *
+ * Callbacks may load other assets.
+ *
+ * @return void
+ */
+auto
+asset_pack::poll () -> void
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    if (m_completed.empty ())
+      return;
+    std::swap (m_running, m_completed);
+  }
+
+  for (auto &done : m_running)
+    {
+      if (done.opening)
+        {
+          if (m_on_open)
+            m_on_open (done.succeeded);
+          continue;
+        }
+      if (!done.succeeded)
+        {
+          done.on_load (nullptr, 0);
+          continue;
+        }
+
+      const auto size = m_assets[done.asset].size;
+#ifndef __EMSCRIPTEN__
+      m_stats.fetched += size;
+#endif
+      ++m_stats.loaded;
+      done.on_load (get_data (done.asset), size);
+    }
+  m_running.clear ();
+}
+
+/**@brief Check the header of a pack
+ *
+ * @param start of the pack
+ * @param bytes available
+ * @param size of the index that follows the header
+ * @param number of assets in the index
+ * @return true if the header is valid, false otherwise
+ */
+auto
+asset_pack::read_header (const uint8_t *data, std::size_t size,
+                         uint32_t &index_size, uint32_t &asset_num) -> bool
+{
+  if (size < header_size
+      || std::memcmp (data, pack_magic, sizeof (pack_magic)) != 0
+      || read_le (data + 4, 4) != pack_version)
+    return false;
+  asset_num = static_cast<uint32_t> (read_le (data + 8, 4));
+  index_size = static_cast<uint32_t> (read_le (data + 12, 4));
+  return true;
+}
+
+/**@brief Read the index of a pack
+ *
+ * @param start of the index
+ * @param size of the index
+ * @param number of assets in the index
+ * @param limit bytes of the pack every asset has to end within
+ * @return true if the index is valid, false otherwise
+ */
+auto
+asset_pack::read_index (const uint8_t *data, std::size_t size,
+                        uint32_t asset_num, uint64_t limit) -> bool
+{
+  if (asset_num > size / 18)
+    return false;
+  m_assets.resize (asset_num);
+  std::size_t offset = 0;
+  for (auto &entry : m_assets)
+    {
+      if (offset + 18 > size)
+        return false;
+      entry.offset = read_le (data + offset, 8);
+      entry.size = read_le (data + offset + 8, 8);
+      if (entry.size > limit || entry.offset > limit - entry.size)
+        return false;
+      const auto name_length = read_le (data + offset + 16, 2);
+      offset += 18;
+      if (offset + name_length > size)
+        return false;
+      entry.name.assign (reinterpret_cast<const char *> (data + offset),
+                         name_length);
+      offset += name_length;
+      m_stats.pack_size
+          = std::max (m_stats.pack_size, entry.offset + entry.size);
+    }
+  return true;
+}
+
+/**@brief Data of a loaded asset
+ */
+auto
+asset_pack::get_data (asset_handle asset) const -> const uint8_t *
+{
+  const auto &entry = m_assets[asset];
+#ifdef __EMSCRIPTEN__
+  if (!m_pack_data.empty ())
+    return m_pack_data.data () + entry.offset;
+  return entry.data.data ();
+#else
+  return m_mapping + entry.offset;
+#endif
+}
+
+/**@brief Queue a callback for poll ()
+ */
+auto
+asset_pack::complete (completion done) -> void
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_completed.push_back (std::move (done));
+}
+
+#ifdef __EMSCRIPTEN__
+/**@brief Download a range of the pack
+ *
+ * @param offset of the range
+ * @param size of the range, not 0
+ * @param request the range is for, deleted once the download ends
+ * @return void
+ */
+auto
+asset_pack::fetch_range (uint64_t offset, uint64_t size,
+                         fetch_request *request) -> void
+{
+  request->offset = offset;
+  request->size = size;
+
+  char range[48];
+  snprintf (range, sizeof (range), "bytes=%llu-%llu",
+            static_cast<unsigned long long> (offset),
+            static_cast<unsigned long long> (offset + size - 1));
+  const char *headers[] = { "Range", range, nullptr };
+
+  emscripten_fetch_attr_t attributes;
+  emscripten_fetch_attr_init (&attributes);
+  std::strcpy (attributes.requestMethod, "GET");
+  attributes.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+  attributes.requestHeaders = headers;
+  attributes.userData = request;
+  attributes.onsuccess = on_fetch_success;
+  attributes.onerror = on_fetch_error;
+  emscripten_fetch (&attributes, m_path.c_str ());
+}
+
+/**@brief Go on with a downloaded range
+ *
+ * @param request the range was downloaded for
+ * @param data of the range
+ * @param size of the range
+ * @return void
+ */
+auto
+asset_pack::on_fetched (const fetch_request &request, const uint8_t *data,
+                        std::size_t size) -> void
+{
+  switch (request.stage)
+    {
+    case fetch_stage::header:
+      {
+        uint32_t index_size = 0, asset_num = 0;
+        if (!read_header (data, size, index_size, asset_num))
+          {
+            fprintf (stderr, "%s is not an asset pack\n", m_path.c_str ());
+            complete ({ true, invalid_asset, false, nullptr });
+          }
+        else if (!m_pack_data.empty ())
+          {
+            // the whole pack came with the header
+            m_open = index_size <= m_pack_data.size () - header_size
+                     && read_index (m_pack_data.data () + header_size,
+                                    index_size, asset_num,
+                                    m_pack_data.size ());
+            complete ({ true, invalid_asset, m_open, nullptr });
+          }
+        else if (index_size == 0)
+          {
+            m_open = asset_num == 0;
+            complete ({ true, invalid_asset, m_open, nullptr });
+          }
+        else
+          {
+            fetch_range (header_size, index_size,
+                         new fetch_request{ this, m_generation,
+                                            fetch_stage::index, invalid_asset,
+                                            asset_num, 0, 0, nullptr });
+          }
+        break;
+      }
+    case fetch_stage::index:
+      // the size of the pack is only known if it all came with the index
+      m_open = read_index (data, size, request.asset_num,
+                           m_pack_data.empty () ? UINT64_MAX
+                                                : m_pack_data.size ());
+      complete ({ true, invalid_asset, m_open, nullptr });
+      break;
+    case fetch_stage::asset:
+      {
+        auto &entry = m_assets[request.asset];
+        if (size != entry.size)
+          {
+            // a truncated range, the loaders read entry.size bytes
+            fprintf (stderr, "%s: got %zu bytes of %s instead of %llu\n",
+                     m_path.c_str (), size, entry.name.c_str (),
+                     static_cast<unsigned long long> (entry.size));
+            complete ({ false, request.asset, false, request.on_load });
+            break;
+          }
+        entry.data.assign (data, data + size);
+        m_stats.heap_bytes += size;
+        complete ({ false, request.asset, true, request.on_load });
+        break;
+      }
+    }
+}
+
+/**@brief Handle a completed download
+ */
+void
+asset_pack::on_fetch_success (emscripten_fetch_t *fetch)
+{
+  auto *request = static_cast<fetch_request *> (fetch->userData);
+  auto &pack = *request->pack;
+  if (request->generation == pack.m_generation)
+    {
+      auto data = reinterpret_cast<const uint8_t *> (fetch->data);
+      auto size = static_cast<std::size_t> (fetch->numBytes);
+      pack.m_stats.fetched += size;
+
+      // servers that don't support ranges send the whole pack, it is kept
+      // and every asset is taken from it
+      if (fetch->status == 200 && size > request->size)
+        {
+          pack.m_pack_data.assign (data, data + size);
+          pack.m_stats.heap_bytes += size;
+          data += std::min<std::size_t> (request->offset, size);
+          size -= std::min<std::size_t> (request->offset, size);
+        }
+      pack.on_fetched (*request, data,
+                       std::min<std::size_t> (size, request->size));
+    }
+  emscripten_fetch_close (fetch);
+  delete request;
+}
+
+/**@brief Handle a failed download
+ */
+void
+asset_pack::on_fetch_error (emscripten_fetch_t *fetch)
+{
+  auto *request = static_cast<fetch_request *> (fetch->userData);
+  auto &pack = *request->pack;
+  if (request->generation == pack.m_generation)
+    {
+      fprintf (stderr, "Failed to download %s: HTTP %d\n",
+               pack.m_path.c_str (), fetch->status);
+      if (request->stage == fetch_stage::asset)
+        pack.complete ({ false, request->asset, false, request->on_load });
+      else
+        pack.complete ({ true, invalid_asset, false, nullptr });
+    }
+  emscripten_fetch_close (fetch);
+  delete request;
+}
+#else
+/**@brief Read the requested assets ahead until the pack is closed
+ *
+ * Every page of an asset is touched once on this thread, so the first use
+ * of the asset on the main thread doesn't wait for the disk.
+ *
+ * @return void
+ */
+auto
+asset_pack::loader_loop () -> void
+{
+  set_trace_thread_name ("asset loader");
+  std::unique_lock<std::mutex> lock (m_mutex);
+  for (;;)
+    {
+      m_wake.wait (lock,
+                   [this] { return m_stopping || !m_requests.empty (); });
+      if (m_stopping)
+        return;
+      auto request = std::move (m_requests.front ());
+      m_requests.erase (m_requests.begin ());
+      lock.unlock ();
+
+      {
+        TRACE_ZONE ("asset_pack::read_ahead");
+        const auto &entry = m_assets[request.asset];
+        const volatile uint8_t *data = m_mapping + entry.offset;
+        constexpr std::size_t page_size = 4096;
+        for (std::size_t i = 0; i < entry.size; i += page_size)
+          static_cast<void> (data[i]);
+      }
+
+      lock.lock ();
+      m_completed.push_back (std::move (request));
+    }
+}
+#endif
+
+/**@brief Pack files in an asset pack, each asset is named after the path of
+ * its file
+ *
+ * @param path of the pack
+ * @param paths of the files
+ * @param number of files
+ * @return true if the pack was written, false otherwise
+ */
+auto
+write_asset_pack (const char *path, const char *const *files, int file_num)
+    -> bool
+{
+  std::vector<std::vector<uint8_t> > contents (file_num);
+  for (auto i = 0; i < file_num; ++i)
+    {
+      auto file = std::fopen (files[i], "rb");
+      if (!file)
+        {
+          fprintf (stderr, "Failed to read %s\n", files[i]);
+          return false;
+        }
+      uint8_t buffer[4096];
+      std::size_t read;
+      while ((read = std::fread (buffer, 1, sizeof (buffer), file)) > 0)
+        contents[i].insert (contents[i].end (), buffer, buffer + read);
+      std::fclose (file);
+    }
+
+  auto index_size = std::size_t (0);
+  for (auto i = 0; i < file_num; ++i)
+    {
+      if (std::strlen (files[i]) > 0xffff)
+        {
+          fprintf (stderr, "Asset name too long: %s\n", files[i]);
+          return false;
+        }
+      index_size += 18 + std::strlen (files[i]);
+    }
+  const auto align = [] (uint64_t offset) {
+    return (offset + asset_pack::asset_alignment - 1)
+           & ~uint64_t (asset_pack::asset_alignment - 1);
+  };
+
+  std::vector<uint8_t> pack (pack_magic, pack_magic + sizeof (pack_magic));
+  write_le (pack, 4, pack_version);
+  write_le (pack, 4, static_cast<uint64_t> (file_num));
+  write_le (pack, 4, index_size);
+  auto offset = align (asset_pack::header_size + index_size);
+  for (auto i = 0; i < file_num; ++i)
+    {
+      const auto name_length = std::strlen (files[i]);
+      write_le (pack, 8, offset);
+      write_le (pack, 8, contents[i].size ());
+      write_le (pack, 2, name_length);
+      pack.insert (pack.end (), files[i], files[i] + name_length);
+      offset = align (offset + contents[i].size ());
+    }
+  for (const auto &content : contents)
+    {
+      pack.resize (align (pack.size ()), 0);
+      pack.insert (pack.end (), content.begin (), content.end ());
+    }
+
+  auto file = std::fopen (path, "wb");
+  const auto written
+      = file ? std::fwrite (pack.data (), 1, pack.size (), file) : 0;
+  if (!file || std::fclose (file) != 0 || written != pack.size ())
+    {
+      fprintf (stderr, "Failed to write %s\n", path);
+      return false;
+    }
+  printf ("%d assets packed in %s (%zu bytes)\n", file_num, path,
+          pack.size ());
+  return true;
+}
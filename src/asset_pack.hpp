@@ -0,0 +1,157 @@
+/**@file asset_pack.hpp
+ * @brief contains function prototypes for the asset pack and its loader
+ *
+ * Every asset of the game is stored in a single pack: a small index (names,
+ * offsets and sizes) followed by the data of every asset. Native builds map
+ * the pack in memory, nothing is copied and only the pages that are used are
+ * ever read. Web builds download the index and then each asset on its own
+ * with HTTP range requests, so the game starts before the large assets have
+ * arrived.
+ *
+ * Assets are loaded by handle in the background, their callbacks run on the
+ * thread calling poll (), once per frame.
+ *
+ * Format, little endian:
+ *   "TPAK", version (4 bytes), asset number (4), index size in bytes (4)
+ *   index, for every asset: offset (8), size (8), name length (2), name
+ *   data of the assets, each one aligned to asset_alignment bytes
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+struct emscripten_fetch_t;
+#endif
+
+using asset_handle = int;
+constexpr asset_handle invalid_asset = -1;
+
+/**@brief what loading the assets cost
+ */
+struct asset_stats
+{
+  uint64_t pack_size;  // bytes of the whole pack
+  uint64_t fetched;    // bytes downloaded (web) or read ahead (native)
+  uint64_t heap_bytes; // bytes of assets copied in the heap
+  unsigned int loaded; // assets whose callback ran
+};
+
+class asset_pack
+{
+public:
+  // called with the data of the asset, or null if it could not be loaded.
+  // The data stays valid as long as the pack is open
+  using load_callback
+      = std::function<void (const uint8_t *data, std::size_t size)>;
+  using open_callback = std::function<void (bool opened)>;
+
+  static constexpr std::size_t header_size = 16;
+  static constexpr std::size_t asset_alignment = 64;
+
+  asset_pack ();
+  ~asset_pack ();
+
+  asset_pack (const asset_pack &) = delete;
+  asset_pack &operator= (const asset_pack &) = delete;
+
+  auto open (const char *path, open_callback on_open) -> void;
+  auto close () -> void;
+  auto find (const char *name) const -> asset_handle;
+  auto load (asset_handle asset, load_callback on_load) -> void;
+  auto poll () -> void;
+
+  // getters
+  auto
+  is_open () const -> bool
+  {
+    return m_open;
+  }
+
+  auto
+  get_stats () const -> const asset_stats &
+  {
+    return m_stats;
+  }
+
+private:
+  /**@brief an asset of the index
+   */
+  struct asset_entry
+  {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    std::vector<uint8_t> data; // downloaded data (web builds only)
+  };
+
+  /**@brief a callback waiting to be run by poll ()
+   */
+  struct completion
+  {
+    bool opening; // callback of open (), not of an asset
+    asset_handle asset;
+    bool succeeded;
+    load_callback on_load;
+  };
+
+  auto read_header (const uint8_t *data, std::size_t size,
+                    uint32_t &index_size, uint32_t &asset_num) -> bool;
+  auto read_index (const uint8_t *data, std::size_t size, uint32_t asset_num,
+                   uint64_t limit) -> bool;
+  auto get_data (asset_handle asset) const -> const uint8_t *;
+  auto complete (completion done) -> void;
+
+#ifdef __EMSCRIPTEN__
+  struct fetch_request;
+
+  auto fetch_range (uint64_t offset, uint64_t size, fetch_request *request)
+      -> void;
+  auto on_fetched (const fetch_request &request, const uint8_t *data,
+                   std::size_t size) -> void;
+  static void on_fetch_success (emscripten_fetch_t *fetch);
+  static void on_fetch_error (emscripten_fetch_t *fetch);
+#else
+  auto loader_loop () -> void;
+#endif
+
+  std::string m_path;
+  unsigned int m_generation; // bumped by close (), older requests are stale
+  bool m_open;
+  open_callback m_on_open;
+  std::vector<asset_entry> m_assets;
+  asset_stats m_stats;
+
+#ifdef __EMSCRIPTEN__
+  // whole pack, kept when the server ignored a range request and sent it
+  std::vector<uint8_t> m_pack_data;
+#else
+  const uint8_t *m_mapping; // the whole pack, mapped read only
+  std::size_t m_mapping_size;
+
+  // background loader: reads the pages of the requested assets ahead so
+  // that using them never waits for the disk
+  std::thread m_loader;
+  bool m_stopping;
+  std::vector<completion> m_requests;
+#endif
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<completion> m_completed;
+  std::vector<completion> m_running; // swapped with m_completed by poll ()
+};
+
+auto write_asset_pack (const char *path, const char *const *files,
+                       int file_num) -> bool;
+
+#endif /* ASSET_PACK_H */
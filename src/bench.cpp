@@ -0,0 +1,720 @@
+/** @file bench.cpp
+ *  @brief microbenchmarks of the game logic hot paths
+ *
+ *  Standalone program timing the collision check, move generation, every
+ *  branch of game::update_playing, locking with 0 to 4 line clears,
+ *  tetromino generation, hashing, the transposition table and
+ *  game_renderer::draw_playing (against the null renderer, recording and
+ *  comparing command buffers, and whole frames rasterized by the software
+ *  renderer) on empty, half-full and near-topout boards, and locking and
+ *  clearing under deep stacks of a 300x10000 dynamic board. Results are
+ *  written on stdout as JSON with the time and the number of heap
+ *  allocations per operation, so that builds can be compared. Thousands of
+ *  frames of random play are also simulated and drawn, bench fails if any
+ *  of them allocates once warmed up (see alloc_counter.hpp).
+ *
+ *  usage: bench [FILTER]   only run the benchmarks whose name contains FILTER
+ */
+
+#include "alloc_counter.hpp"
+#include "board.hpp"
+#include "command_buffer.hpp"
+#include "game.hpp"
+#include "game_renderer.hpp"
+#include "movegen.hpp"
+#include "null_renderer.hpp"
+#include "rng.hpp"
+#include "software_renderer.hpp"
+#include "trace.hpp"
+#include "transposition_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/** @brief access to the private steps of the game and its renderer
+ */
+struct bench_access
+{
+  static auto
+  get_board (game &p_game) -> board &
+  {
+    return p_game.m_board;
+  }
+  static auto
+  get_active_tetromino (game &p_game) -> tetromino_instance &
+  {
+    return p_game.m_active_tetromino;
+  }
+  static auto
+  hold_gravity (game &p_game) -> void
+  {
+    p_game.m_frames_until_fall = 1 << 30;
+  }
+  static auto
+  release_gravity (game &p_game) -> void
+  {
+    p_game.m_frames_until_fall = 1;
+  }
+  static auto
+  set_fall_step (game &p_game, int frames) -> int
+  {
+    const auto previous = p_game.m_frames_per_fall_step;
+    p_game.m_frames_per_fall_step = frames;
+    return previous;
+  }
+  static auto
+  invalidate_ghost (game &p_game) -> void
+  {
+    p_game.m_ghost_board_revision = p_game.m_board.revision + 1;
+  }
+  static auto
+  generate_tetromino (game &p_game) -> bool
+  {
+    return p_game.generate_tetromino ();
+  }
+  static auto
+  summon_tetromino_to_board (game &p_game, const tetromino_instance &instance)
+      -> lock_result
+  {
+    return p_game.summon_tetromino_to_board (p_game.m_board, instance);
+  }
+  static auto
+  draw_playing (game_renderer &p_game_renderer, renderer &p_renderer,
+                const game_view &p_view) -> void
+  {
+    auto &commands = p_game_renderer.m_commands;
+    commands.clear ();
+    p_game_renderer.draw_playing (p_renderer, commands, p_view, 0.5f);
+    commands.submit (p_renderer);
+  }
+  static auto
+  record_playing (game_renderer &p_game_renderer, renderer &p_renderer,
+                  command_buffer &p_commands, const game_view &p_view) -> void
+  {
+    p_commands.clear ();
+    p_game_renderer.draw_playing (p_renderer, p_commands, p_view, 0.5f);
+  }
+};
+
+struct bench_result
+{
+  const char *name;
+  const char *fixture;
+  unsigned long iterations; // per repetition
+  double ns_per_op;         // best repetition
+  double allocs_per_op;     // average over every repetition
+};
+
+static constexpr auto board_width = board::width;
+static constexpr auto board_height = board::height;
+static constexpr auto repetitions = 5;
+static constexpr std::chrono::milliseconds min_calibration_time (5);
+static constexpr std::chrono::milliseconds repetition_time (40);
+
+static const char *bench_filter = nullptr;
+static std::vector<bench_result> bench_results;
+static volatile long bench_sink; // keeps results of pure functions alive
+
+/** @brief Time an operation
+ *
+ *  The number of iterations is doubled until a run is long enough to be
+ *  measured, then scaled so that each of the repetitions lasts about
+ *  repetition_time. The fastest repetition is kept as it is the least
+ *  disturbed by the rest of the system.
+ *
+ *  @param name of the benchmark
+ *  @param name of the board fixture
+ *  @param operation to be timed, called once per iteration
+ *  @return void
+ */
+template <typename operation>
+static void
+run_bench (const char *name, const char *fixture, operation &&op)
+{
+  if (bench_filter && !strstr (name, bench_filter))
+    return;
+
+  using clock = std::chrono::steady_clock;
+  auto run = [&op] (unsigned long iterations) {
+    const auto start = clock::now ();
+    for (auto i = 0ul; i < iterations; ++i)
+      op ();
+    return clock::now () - start;
+  };
+
+  auto iterations = 1ul;
+  auto elapsed = run (iterations);
+  while (elapsed < min_calibration_time)
+    {
+      iterations *= 2;
+      elapsed = run (iterations);
+    }
+  iterations = std::max (1ul, static_cast<unsigned long> (
+                                  iterations * (repetition_time / elapsed)));
+
+  auto best_ns = 0.0;
+  const auto allocations_before = get_allocation_count ();
+  for (auto i = 0; i < repetitions; ++i)
+    {
+      const auto ns = std::chrono::duration<double, std::nano> (
+                          run (iterations))
+                          .count ()
+                      / iterations;
+      if (i == 0 || ns < best_ns)
+        best_ns = ns;
+    }
+  const auto allocs
+      = static_cast<double> (get_allocation_count () - allocations_before)
+        / (static_cast<double> (iterations) * repetitions);
+
+  bench_results.push_back ({ name, fixture, iterations, best_ns, allocs });
+}
+
+/** @brief Time an operation that uses up its fixture
+ *
+ *  Every repetition starts from a fresh fixture made by setup, which isn't
+ *  timed, then times a batch of calls of the operation. The fastest
+ *  repetition is kept.
+ *
+ *  @param name of the benchmark
+ *  @param name of the fixture
+ *  @param batch number of calls of the operation per repetition
+ *  @param setup called before every repetition
+ *  @param operation to be timed
+ *  @return void
+ */
+template <typename setup_operation, typename operation>
+static void
+run_batch_bench (const char *name, const char *fixture, unsigned long batch,
+                 setup_operation &&setup, operation &&op)
+{
+  if (bench_filter && !strstr (name, bench_filter))
+    return;
+
+  constexpr auto batch_repetitions = 20;
+  using clock = std::chrono::steady_clock;
+  auto best_ns = 0.0;
+  auto allocations = 0ul;
+  for (auto i = 0; i < batch_repetitions; ++i)
+    {
+      setup ();
+      const auto allocations_before = get_allocation_count ();
+      const auto start = clock::now ();
+      for (auto j = 0ul; j < batch; ++j)
+        op ();
+      const auto ns
+          = std::chrono::duration<double, std::nano> (clock::now () - start)
+                .count ()
+            / batch;
+      allocations += get_allocation_count () - allocations_before;
+      if (i == 0 || ns < best_ns)
+        best_ns = ns;
+    }
+  bench_results.push_back (
+      { name, fixture, batch, best_ns,
+        static_cast<double> (allocations)
+            / (static_cast<double> (batch) * batch_repetitions) });
+}
+
+/** @brief Fill a cell of a fixture board
+ */
+static void
+fill_cell (board &p_board, unsigned int x, unsigned int y, tetromino_type type)
+{
+  p_board.rows[y] |= board_row (1) << (x + board::wall_bits);
+  p_board.colors[y * p_board.width + x] = static_cast<uint8_t> (type);
+  p_board.column_tops[x] = std::min (p_board.column_tops[x],
+                                     static_cast<int> (y));
+}
+
+/** @brief Fill the given number of bottom rows with one hole per row
+ *
+ *  The holes move around so that the skyline isn't flat, the top rows of the
+ *  garbage also have holes under overhangs.
+ */
+static board
+make_garbage_board (unsigned int rows)
+{
+  board fixture = {};
+  clear_board (fixture);
+  for (auto y = board_height - rows; y < board_height; ++y)
+    {
+      const auto hole = (y * 7) % board_width;
+      for (auto x = 0u; x < board_width; ++x)
+        {
+          if (x != hole)
+            fill_cell (fixture, x, y,
+                       static_cast<tetromino_type> ((x + y) % 7));
+        }
+    }
+  rehash_board (fixture);
+  return fixture;
+}
+
+/** @brief Board on which a vertical I in the rightmost column clears the
+ *  given number of lines
+ */
+static board
+make_line_clear_board (unsigned int lines)
+{
+  board fixture = {};
+  clear_board (fixture);
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const auto y = board_height - 1 - i;
+      const auto filled = i < lines ? board_width - 1 : board_width / 2;
+      for (auto x = 0u; x < filled; ++x)
+        fill_cell (fixture, x, y, tetromino_type::O);
+    }
+  rehash_board (fixture);
+  return fixture;
+}
+
+/** @brief Large dynamic board whose given number of bottom rows are full
+ *  but for a well in the rightmost 4 columns
+ */
+static dynamic_board
+make_well_board (unsigned int width, unsigned int height, unsigned int rows)
+{
+  dynamic_board fixture = {};
+  reset_board (fixture, width, height);
+  tetromino_instance horizontal_i = {};
+  horizontal_i.m_tetromino_type = tetromino_type::I;
+  for (auto y = height - rows; y < height; ++y)
+    {
+      for (auto x = 0u; x + 2 * tetromino::block_num <= width;
+           x += tetromino::block_num)
+        {
+          horizontal_i.m_pos = coords (x, y - 1);
+          lock_tetromino (fixture, horizontal_i);
+        }
+    }
+  return fixture;
+}
+
+/** @brief Play and draw frames with random inputs, count the allocations
+ *  made once warmed up
+ *
+ *  Games are restarted as soon as they are over, so the title screen, the
+ *  bag refills and the line clears of many games are covered.
+ *
+ *  @return number of allocations made after the warm up frames
+ */
+static unsigned long
+count_frame_allocations (renderer &p_renderer, game_renderer &p_game_renderer)
+{
+  constexpr auto warm_up_frames = 2000u;
+  constexpr auto frames = 20000u;
+
+  game played_game (7);
+  rng input_rng (7);
+  auto allocations_before = 0ul;
+  for (auto frame = 0u; frame < frames; ++frame)
+    {
+      if (frame == warm_up_frames)
+        allocations_before = get_allocation_count ();
+
+      game_input input = {};
+      input.m_start = played_game.view ().m_state != game_state::playing;
+      switch (input_rng.next () % 8)
+        {
+        case 0:
+          input.m_move_left = true;
+          break;
+        case 1:
+          input.m_move_right = true;
+          break;
+        case 2:
+          input.m_rotate_clockwise = true;
+          break;
+        case 3:
+          input.m_soft_drop = true;
+          break;
+        case 4:
+          input.m_hard_drop = input_rng.next () % 8 == 0;
+          break;
+        }
+      played_game.step (input);
+      p_renderer.clear ();
+      p_game_renderer.draw (p_renderer, played_game.view (), 0.5f);
+      p_renderer.present ();
+    }
+  return get_allocation_count () - allocations_before;
+}
+
+struct fixture
+{
+  const char *name;
+  board m_board;
+};
+
+int
+main (int argc, char *argv[])
+{
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [FILTER]\n", argv[0]);
+      return 1;
+    }
+  if (argc == 2)
+    bench_filter = argv[1];
+
+  const fixture fixtures[] = {
+    { "empty", make_garbage_board (0) },
+    { "half_full", make_garbage_board (board_height / 2) },
+    { "near_topout", make_garbage_board (board_height - 3) },
+  };
+
+  game bench_game (1);
+  game_input start_input = {};
+  start_input.m_start = true;
+  bench_game.step (start_input);
+  auto &game_board = bench_access::get_board (bench_game);
+  auto &active = bench_access::get_active_tetromino (bench_game);
+
+  // every piece in every rotation across the board, at the top, middle and
+  // bottom rows
+  std::vector<tetromino_instance> overlap_cases;
+  for (auto type = 0; type < static_cast<int> (tetromino_type::count); ++type)
+    for (auto rotation = 0u; rotation < tetromino::rotation_num; ++rotation)
+      for (auto x = -2; x < static_cast<int> (board_width); ++x)
+        for (auto y : { 0, static_cast<int> (board_height) / 2,
+                        static_cast<int> (board_height) - 4 })
+          {
+            tetromino_instance instance = {};
+            instance.m_tetromino_type = static_cast<tetromino_type> (type);
+            instance.m_rotation = rotation;
+            instance.m_pos = coords (x, y);
+            overlap_cases.push_back (instance);
+          }
+
+  // piece spawned like generate_tetromino () does
+  tetromino_instance spawn = {};
+  spawn.m_tetromino_type = tetromino_type::T;
+  spawn.m_pos = coords ((board_width - 4) / 2, 0);
+
+  for (const auto &f : fixtures)
+    {
+      run_bench ("is_overlap", f.name, [&f, &overlap_cases] () {
+        static auto i = 0u;
+        bench_sink += is_overlap (overlap_cases[i], f.m_board);
+        if (++i == overlap_cases.size ())
+          i = 0;
+      });
+
+      run_bench ("drop_distance", f.name, [&f, &spawn] () {
+        bench_sink += drop_distance (spawn, f.m_board);
+      });
+
+      // every piece in turn, as a bot looking ahead would
+      move_generator generator;
+      run_bench ("move_generator::generate", f.name, [&] () {
+        static auto type = 0;
+        auto piece = spawn;
+        piece.m_tetromino_type = static_cast<tetromino_type> (type);
+        bench_sink += generator.generate (f.m_board, piece).size ();
+        type = (type + 1) % static_cast<int> (tetromino_type::count);
+      });
+
+      game_board = f.m_board;
+
+      // one branch of update_playing per input, gravity is held so that the
+      // tetromino doesn't fall in between
+      auto bench_input = [&] (const char *name, tetromino_instance from,
+                              game_input input) {
+        run_bench (name, f.name, [&] () {
+          active = from;
+          bench_access::hold_gravity (bench_game);
+          bench_game.update_playing (input);
+        });
+      };
+      game_input input = {};
+      input.m_move_left = true;
+      bench_input ("update_playing.move_left", spawn, input);
+      auto at_left_wall = spawn;
+      at_left_wall.m_pos.x = 0;
+      bench_input ("update_playing.move_left_blocked", at_left_wall, input);
+      input = {};
+      input.m_move_right = true;
+      bench_input ("update_playing.move_right", spawn, input);
+      input = {};
+      input.m_rotate_clockwise = true;
+      bench_input ("update_playing.rotate_clockwise", spawn, input);
+      input = {};
+      input.m_rotate_anticlockwise = true;
+      bench_input ("update_playing.rotate_anticlockwise", spawn, input);
+      // vertical I against the left wall only fits after a kick
+      tetromino_instance kicked = {};
+      kicked.m_tetromino_type = tetromino_type::I;
+      kicked.m_rotation = 3;
+      kicked.m_pos = coords (-1, 0);
+      input = {};
+      input.m_rotate_clockwise = true;
+      bench_input ("update_playing.rotate_kick", kicked, input);
+      input = {};
+      input.m_soft_drop = true;
+      bench_input ("update_playing.soft_drop", spawn, input);
+      run_bench ("update_playing.gravity", f.name, [&] () {
+        active = spawn;
+        bench_access::release_gravity (bench_game);
+        bench_game.update_playing (game_input{});
+      });
+      // 20G, a fall step of 0 frames lands the tetromino in a single step
+      const auto fall_step = bench_access::set_fall_step (bench_game, 0);
+      active = spawn;
+      bench_access::release_gravity (bench_game);
+      bench_game.update_playing (game_input{});
+      if (active.m_pos.y != spawn.m_pos.y + drop_distance (spawn, game_board))
+        {
+          fprintf (stderr, "20G didn't land the tetromino on %s\n", f.name);
+          return 1;
+        }
+      run_bench ("update_playing.gravity_20g", f.name, [&] () {
+        active = spawn;
+        bench_access::release_gravity (bench_game);
+        bench_game.update_playing (game_input{});
+      });
+      bench_access::set_fall_step (bench_game, fall_step);
+
+      // the hard drop locks the piece and spawns the next one, the board is
+      // restored every iteration (see board_restore for the cost of that)
+      run_bench ("board_restore", f.name,
+                 [&] () { game_board = f.m_board; });
+      // the full recompute the incremental board hash avoids
+      run_bench ("rehash_board", f.name, [&] () {
+        rehash_board (game_board);
+        bench_sink += game_board.hash;
+      });
+      input = {};
+      input.m_hard_drop = true;
+      // restoring the board also restores its revision, the memoized ghost
+      // is dropped so that every iteration searches the landing row
+      run_bench ("update_playing.hard_drop", f.name, [&] () {
+        game_board = f.m_board;
+        bench_access::invalidate_ghost (bench_game);
+        active = spawn;
+        bench_access::hold_gravity (bench_game);
+        bench_game.update_playing (input);
+      });
+    }
+
+  // locking with every number of line clears, the I drops in the rightmost
+  // column of make_line_clear_board
+  static const char *const line_fixtures[]
+      = { "0_lines", "1_line", "2_lines", "3_lines", "4_lines" };
+  tetromino_instance vertical_i = {};
+  vertical_i.m_tetromino_type = tetromino_type::I;
+  vertical_i.m_rotation = 3;
+  vertical_i.m_pos = coords (board_width - 2, board_height - 4);
+  for (auto lines = 0u; lines <= tetromino::block_num; ++lines)
+    {
+      const auto line_board = make_line_clear_board (lines);
+      game_board = line_board;
+      if (bench_access::summon_tetromino_to_board (bench_game, vertical_i)
+              .lines.count
+          != lines)
+        {
+          fprintf (stderr, "line clear fixture %u is broken\n", lines);
+          return 1;
+        }
+      auto rehashed = game_board;
+      rehash_board (rehashed);
+      if (rehashed.hash != game_board.hash)
+        {
+          fprintf (stderr, "board hash after %u lines is stale\n", lines);
+          return 1;
+        }
+      run_bench ("summon_tetromino_to_board", line_fixtures[lines], [&] () {
+        game_board = line_board;
+        bench_access::summon_tetromino_to_board (bench_game, vertical_i);
+      });
+    }
+
+  // a 300x10000 dynamic board with 2000 rows of garbage and a well in the
+  // rightmost 4 columns. Horizontal I drop in turn in every 4 columns: the
+  // one in the well clears the lowest row while the others build a new row
+  // on top, so the stack keeps its height. This is the average over 75
+  // locks of which one clears, see dynamic_board.clear_bottom for a clear
+  constexpr auto large_width = 300u;
+  constexpr auto large_height = 10000u;
+  constexpr auto large_garbage = 2000u;
+  constexpr auto large_slots = large_width / tetromino::block_num;
+  auto large_board = make_well_board (large_width, large_height,
+                                      large_garbage);
+  tetromino_instance horizontal_i = {};
+  horizontal_i.m_tetromino_type = tetromino_type::I;
+  auto large_slot = 0u;
+  run_bench ("dynamic_board.lock", "300x10000", [&] () {
+    horizontal_i.m_pos = coords (large_slot * tetromino::block_num, 0);
+    horizontal_i.m_pos.y += drop_distance (horizontal_i, large_board);
+    lock_tetromino (large_board, horizontal_i);
+    clear_full_rows (large_board, horizontal_i.m_pos.y, tetromino::block_num);
+    large_slot = (large_slot + 1) % large_slots;
+  });
+  const auto large_hash = large_board.hash;
+  rehash_board (large_board);
+  if (get_stored_rows (large_board) > large_garbage + 1
+      || large_board.hash != large_hash)
+    {
+      fprintf (stderr, "large board lost track of its lines or hash\n");
+      return 1;
+    }
+
+  // an I dropped in the well clears the bottom row under every other stored
+  // row, every call clears once. The time should not grow with the stack
+  static const char *const deep_fixtures[] = { "128_rows", "8192_rows" };
+  constexpr unsigned int deep_rows[] = { 128, 8192 };
+  constexpr auto deep_batch = 64u;
+  for (auto i = 0u; i < 2; ++i)
+    {
+      const auto deep_board
+          = make_well_board (large_width, large_height, deep_rows[i]);
+      auto board_copy = deep_board;
+      tetromino_instance well_i = horizontal_i;
+      well_i.m_pos = coords (large_width - tetromino::block_num, 0);
+      run_batch_bench (
+          "dynamic_board.clear_bottom", deep_fixtures[i], deep_batch,
+          [&] () { board_copy = deep_board; },
+          [&] () {
+            auto dropped = well_i;
+            dropped.m_pos.y += drop_distance (dropped, board_copy);
+            lock_tetromino (board_copy, dropped);
+            bench_sink += clear_full_rows (board_copy, dropped.m_pos.y,
+                                           tetromino::block_num)
+                              .count;
+          });
+      if (bench_filter
+          && !strstr ("dynamic_board.clear_bottom", bench_filter))
+        continue;
+      const auto deep_hash = board_copy.hash;
+      rehash_board (board_copy);
+      if (get_stored_rows (board_copy) != deep_rows[i] - deep_batch
+          || board_copy.hash != deep_hash)
+        {
+          fprintf (stderr, "deep board %s lost track of its lines or hash\n",
+                   deep_fixtures[i]);
+          return 1;
+        }
+    }
+
+  // the full recompute the incremental hash avoids, every stored row
+  run_bench ("dynamic_board.rehash_board", "300x10000", [&] () {
+    rehash_board (large_board);
+    bench_sink += large_board.hash;
+  });
+
+  // the bag is refilled every few calls, allocations included
+  game_board = fixtures[0].m_board;
+  run_bench ("generate_tetromino", "empty", [&] () {
+    bench_sink += bench_access::generate_tetromino (bench_game);
+  });
+
+  run_bench ("game::state_hash", "empty", [&] () {
+    bench_sink += bench_game.state_hash ();
+  });
+
+  // 16 MiB table, well past the caches, probed with as many hits as misses
+  transposition_table table (20);
+  run_bench ("transposition_table.store", "16mib", [&] () {
+    static uint64_t key = 0;
+    ++key;
+    table.store (fmix64 (key), key);
+  });
+  run_bench ("transposition_table.probe", "16mib", [&] () {
+    static uint64_t key = 0;
+    uint64_t value;
+    bench_sink += table.probe (fmix64 (++key), value);
+  });
+
+  // frontend, the null renderer accepts the draw calls and drops them
+  null_renderer bench_null_renderer (800, 800);
+  game_renderer bench_game_renderer;
+  const auto frame_allocations
+      = count_frame_allocations (bench_null_renderer, bench_game_renderer);
+  if (frame_allocations)
+    {
+      fprintf (stderr, "%lu heap allocations in warmed up frames\n",
+               frame_allocations);
+      return 1;
+    }
+  for (const auto &f : fixtures)
+    {
+      game_board = f.m_board;
+      active = spawn;
+      const auto view = bench_game.view ();
+      run_bench ("draw_playing", f.name, [&] () {
+        bench_access::draw_playing (bench_game_renderer, bench_null_renderer,
+                                    view);
+      });
+      // the board layer is redrawn every frame
+      run_bench ("draw_playing.board_changed", f.name, [&] () {
+        ++game_board.revision;
+        bench_access::draw_playing (bench_game_renderer, bench_null_renderer,
+                                    view);
+      });
+      // recording alone, and the comparison that lets unchanged frames be
+      // skipped
+      command_buffer frames[2];
+      run_bench ("command_buffer.record", f.name, [&] () {
+        bench_access::record_playing (bench_game_renderer, bench_null_renderer,
+                                      frames[0], view);
+      });
+      bench_access::record_playing (bench_game_renderer, bench_null_renderer,
+                                    frames[1], view);
+      run_bench ("command_buffer.is_same", f.name, [&] () {
+        bench_sink += frames[0].is_same (frames[1]);
+      });
+    }
+
+  // whole 1280x720 frames rasterized by the software renderer
+  software_renderer bench_software_renderer (1280, 720);
+  game_renderer software_game_renderer;
+  for (const auto &f : fixtures)
+    {
+      game_board = f.m_board;
+      active = spawn;
+      const auto view = bench_game.view ();
+      run_bench ("software_frame", f.name, [&] () {
+        bench_software_renderer.clear ();
+        bench_access::draw_playing (software_game_renderer,
+                                    bench_software_renderer, view);
+        bench_software_renderer.present ();
+      });
+      run_bench ("software_frame.board_changed", f.name, [&] () {
+        ++game_board.revision;
+        bench_software_renderer.clear ();
+        bench_access::draw_playing (software_game_renderer,
+                                    bench_software_renderer, view);
+        bench_software_renderer.present ();
+      });
+    }
+
+#ifdef TETRIS_ENABLE_TRACE
+  run_bench ("trace_zone", "none", [] () { TRACE_ZONE ("bench"); });
+#endif
+
+  printf ("{\n");
+#ifdef __VERSION__
+  printf ("  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+#ifdef NDEBUG
+  printf ("  \"ndebug\": true,\n");
+#else
+  printf ("  \"ndebug\": false,\n");
+#endif
+  printf ("  \"benchmarks\": [\n");
+  for (auto i = 0u; i < bench_results.size (); ++i)
+    {
+      const auto &result = bench_results[i];
+      printf ("    {\"name\": \"%s\", \"fixture\": \"%s\", \"iterations\": "
+              "%lu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}%s\n",
+              result.name, result.fixture, result.iterations,
+              result.ns_per_op, result.allocs_per_op,
+              i + 1 < bench_results.size () ? "," : "");
+    }
+  printf ("  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,531 @@
+/**@file board.cpp
+ * @brief contains functions that modify the boards of a run time size.
+ *
+ * The rules of the boards of a compile time size are templates, they are in
+ * board.hpp.
+ */
+
+#include "board.hpp"
+
+using word = dynamic_board::word;
+using node = dynamic_board::node;
+static constexpr auto no_slot = dynamic_board::no_slot;
+
+// odd, so that every power of it is a distinct odd weight
+static constexpr uint64_t depth_weight_base = 0x9e3779b97f4a7c15ull;
+
+/**@brief Stored row at the given height, bottom row first
+ */
+static auto
+get_depth (const dynamic_board &p_board, unsigned int y) -> unsigned int
+{
+  return p_board.height - 1 - y;
+}
+
+/**@brief rows of a subtree, 0 for no_slot
+ */
+static auto
+get_size (const dynamic_board &p_board, uint32_t slot) -> uint32_t
+{
+  return slot == no_slot ? 0 : p_board.slot_nodes[slot].size;
+}
+
+/**@brief weighted hash of a subtree, 0 for no_slot
+ */
+static auto
+get_subtree_hash (const dynamic_board &p_board, uint32_t slot) -> uint64_t
+{
+  return slot == no_slot ? 0 : p_board.slot_nodes[slot].hash;
+}
+
+/**@brief Recompute the size and the hash of a node from its children
+ */
+static auto
+pull (dynamic_board &p_board, uint32_t slot) -> void
+{
+  auto &slot_node = p_board.slot_nodes[slot];
+  const auto below = get_size (p_board, slot_node.left);
+  slot_node.size = below + 1 + get_size (p_board, slot_node.right);
+  slot_node.hash
+      = get_subtree_hash (p_board, slot_node.left)
+        + p_board.slot_hashes[slot] * p_board.depth_weights[below]
+        + get_subtree_hash (p_board, slot_node.right)
+              * p_board.depth_weights[below + 1];
+}
+
+/**@brief Join two subtrees, the rows of upper go above those of lower
+ *
+ * The node of the higher priority becomes the root, priorities are mixed
+ * slot numbers so that the tree stays balanced on average.
+ *
+ * @return root of the joined tree
+ */
+static auto
+merge (dynamic_board &p_board, uint32_t lower, uint32_t upper) -> uint32_t
+{
+  if (lower == no_slot)
+    return upper;
+  if (upper == no_slot)
+    return lower;
+  if (fmix64 (lower) > fmix64 (upper))
+    {
+      auto &right = p_board.slot_nodes[lower].right;
+      right = merge (p_board, right, upper);
+      pull (p_board, lower);
+      return lower;
+    }
+  auto &left = p_board.slot_nodes[upper].left;
+  left = merge (p_board, lower, left);
+  pull (p_board, upper);
+  return upper;
+}
+
+/**@brief Cut a subtree in its lowest rows and the others
+ *
+ * @param board of the subtree
+ * @param root of the subtree
+ * @param number of rows that go to lower
+ * @param lower set to the root of the lowest rows
+ * @param upper set to the root of the other rows
+ * @return void
+ */
+static auto
+split (dynamic_board &p_board, uint32_t slot, uint32_t rows, uint32_t &lower,
+       uint32_t &upper) -> void
+{
+  if (slot == no_slot)
+    {
+      lower = upper = no_slot;
+      return;
+    }
+  auto &slot_node = p_board.slot_nodes[slot];
+  const auto below = get_size (p_board, slot_node.left);
+  if (rows <= below)
+    {
+      split (p_board, slot_node.left, rows, lower, slot_node.left);
+      upper = slot;
+    }
+  else
+    {
+      split (p_board, slot_node.right, rows - below - 1, slot_node.right,
+             upper);
+      lower = slot;
+    }
+  pull (p_board, slot);
+}
+
+/**@brief Slot of the stored row at the given depth
+ */
+static auto
+find_slot (const dynamic_board &p_board, unsigned int depth) -> uint32_t
+{
+  auto slot = p_board.root;
+  for (;;)
+    {
+      const auto &slot_node = p_board.slot_nodes[slot];
+      const auto below = get_size (p_board, slot_node.left);
+      if (depth == below)
+        return slot;
+      if (depth < below)
+        slot = slot_node.left;
+      else
+        {
+          depth -= below + 1;
+          slot = slot_node.right;
+        }
+    }
+}
+
+/**@brief Recompute the nodes from the root down to the row at the given
+ * depth, after the hash of that row changed
+ */
+static auto
+pull_path (dynamic_board &p_board, uint32_t slot, unsigned int depth) -> void
+{
+  const auto &slot_node = p_board.slot_nodes[slot];
+  const auto below = get_size (p_board, slot_node.left);
+  if (depth < below)
+    pull_path (p_board, slot_node.left, depth);
+  else if (depth > below)
+    pull_path (p_board, slot_node.right, depth - below - 1);
+  pull (p_board, slot);
+}
+
+/**@brief Words of a row, the empty row for the rows above the stack
+ */
+static auto
+get_row (const dynamic_board &p_board, unsigned int y) -> const word *
+{
+  const auto depth = get_depth (p_board, y);
+  if (depth >= get_stored_rows (p_board))
+    return p_board.empty_row.data ();
+  return &p_board.slot_rows[find_slot (p_board, depth) * p_board.row_words];
+}
+
+/**@brief check if a cell is filled
+ */
+static auto
+is_filled (const dynamic_board &p_board, unsigned int x, unsigned int y)
+    -> bool
+{
+  const auto bit = x + board_base::wall_bits;
+  return get_row (p_board, y)[bit / dynamic_board::word_bits]
+         >> (bit % dynamic_board::word_bits) & 1;
+}
+
+/**@brief hash the filled cells of a stored row
+ *
+ * @param board the row belongs to
+ * @param words of the row, walls included
+ * @return hash of the row, 0 if it has no filled cell
+ */
+static auto
+hash_row (const dynamic_board &p_board, const word *row) -> uint64_t
+{
+  uint64_t hash = 0;
+  for (auto i = 0u; i < p_board.row_words; ++i)
+    hash += fmix64 (row[i] ^ p_board.empty_row[i]) * get_row_factor (i);
+  return hash;
+}
+
+/**@brief Store the rows up to the given one, stored rows are left as they
+ * are
+ *
+ * @param board the rows are added to
+ * @param row that must be stored
+ * @return slot of the row
+ */
+static auto
+store_row (dynamic_board &p_board, unsigned int y) -> uint32_t
+{
+  const auto depth = get_depth (p_board, y);
+  while (get_stored_rows (p_board) <= depth)
+    {
+      uint32_t slot;
+      if (!p_board.free_slots.empty ())
+        {
+          slot = p_board.free_slots.back ();
+          p_board.free_slots.pop_back ();
+        }
+      else
+        {
+          // slots given back are emptied, new ones are born empty
+          slot = static_cast<uint32_t> (p_board.slot_hashes.size ());
+          p_board.slot_rows.insert (p_board.slot_rows.end (),
+                                    p_board.empty_row.begin (),
+                                    p_board.empty_row.end ());
+          p_board.slot_colors.resize (p_board.slot_colors.size ()
+                                          + p_board.width,
+                                      board_base::empty_cell);
+          p_board.slot_hashes.push_back (0);
+          p_board.slot_nodes.push_back ({});
+          p_board.depth_weights.push_back (p_board.depth_weights.back ()
+                                           * depth_weight_base);
+        }
+      p_board.slot_nodes[slot] = { no_slot, no_slot, 1, 0 };
+      p_board.root = merge (p_board, p_board.root, slot);
+    }
+  return find_slot (p_board, depth);
+}
+
+/**@brief Empty the slot of a removed row and make it available again
+ */
+static auto
+free_slot (dynamic_board &p_board, uint32_t slot) -> void
+{
+  std::copy (p_board.empty_row.begin (), p_board.empty_row.end (),
+             p_board.slot_rows.begin () + slot * p_board.row_words);
+  std::fill_n (p_board.slot_colors.begin () + slot * p_board.width,
+               p_board.width, board_base::empty_cell);
+  p_board.slot_hashes[slot] = 0;
+  p_board.free_slots.push_back (slot);
+}
+
+/**@brief Recompute the row hashes and the nodes of a subtree
+ */
+static auto
+rehash_subtree (dynamic_board &p_board, uint32_t slot) -> void
+{
+  if (slot == no_slot)
+    return;
+  rehash_subtree (p_board, p_board.slot_nodes[slot].left);
+  rehash_subtree (p_board, p_board.slot_nodes[slot].right);
+  p_board.slot_hashes[slot]
+      = hash_row (p_board, &p_board.slot_rows[slot * p_board.row_words]);
+  pull (p_board, slot);
+}
+
+/**@brief Resize the board and clear it
+ *
+ * @param board to be resized
+ * @param number of columns
+ * @param number of rows
+ * @return void
+ */
+auto
+reset_board (dynamic_board &p_board, unsigned int width, unsigned int height)
+    -> void
+{
+  p_board.width = width;
+  p_board.height = height;
+  p_board.row_words = (width + 2 * board_base::wall_bits
+                       + dynamic_board::word_bits - 1)
+                      / dynamic_board::word_bits;
+
+  p_board.empty_row.assign (p_board.row_words, ~word (0));
+  for (auto x = 0u; x < width; ++x)
+    {
+      const auto bit = x + board_base::wall_bits;
+      p_board.empty_row[bit / dynamic_board::word_bits]
+          &= ~(word (1) << (bit % dynamic_board::word_bits));
+    }
+
+  // the slots are sized for the previous width
+  p_board.slot_rows.clear ();
+  p_board.slot_colors.clear ();
+  p_board.slot_hashes.clear ();
+  p_board.slot_nodes.clear ();
+  p_board.depth_weights.assign (1, 1);
+  clear_board (p_board);
+}
+
+/**@brief Remove every static block from the board, the memory of the rows
+ * is kept for the next blocks
+ */
+auto
+clear_board (dynamic_board &p_board) -> void
+{
+  p_board.root = no_slot;
+  p_board.free_slots.clear ();
+  for (auto slot = 0u; slot < p_board.slot_hashes.size (); ++slot)
+    free_slot (p_board, slot);
+  p_board.column_tops.assign (p_board.width, p_board.height);
+  p_board.hash = 0;
+  ++p_board.revision;
+}
+
+/**@brief Number of rows stored, from the bottom up to the highest block
+ */
+auto
+get_stored_rows (const dynamic_board &p_board) -> unsigned int
+{
+  return get_size (p_board, p_board.root);
+}
+
+/**@brief Recompute the hash of the board from its rows
+ *
+ * Only needed after the rows were changed directly, lock_tetromino and
+ * clear_full_rows keep the hash up to date.
+ *
+ * @param board to be hashed
+ * @return void
+ */
+auto
+rehash_board (dynamic_board &p_board) -> void
+{
+  rehash_subtree (p_board, p_board.root);
+  p_board.hash = get_subtree_hash (p_board, p_board.root);
+}
+
+/**@brief Turn the blocks of a tetromino into static blocks of the board
+ *
+ * Only the rows of the tetromino are touched, the rows between it and the
+ * stack are stored (empty) if it locks above the stack.
+ *
+ * @param board on which the tetromino is locked.
+ * @param instance of the tetromino to be locked, it must not overlap.
+ * @return void
+ */
+auto
+lock_tetromino (dynamic_board &p_board,
+                const tetromino_instance &p_tetromino_instance) -> void
+{
+  const auto &tet = tetromino_data[static_cast<int> (
+      p_tetromino_instance.m_tetromino_type)];
+  const auto &block_coords = tet.block_coords[p_tetromino_instance.m_rotation];
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const int x = p_tetromino_instance.m_pos.x + block_coords[i].x;
+      const int y = p_tetromino_instance.m_pos.y + block_coords[i].y;
+
+      const auto slot = store_row (p_board, y);
+      const auto bit = x + board_base::wall_bits;
+      p_board.slot_rows[slot * p_board.row_words
+                        + bit / dynamic_board::word_bits]
+          |= word (1) << (bit % dynamic_board::word_bits);
+      p_board.slot_colors[slot * p_board.width + x]
+          = static_cast<uint8_t> (p_tetromino_instance.m_tetromino_type);
+      p_board.column_tops[x] = std::min (p_board.column_tops[x], y);
+    }
+
+  const auto &shape = tetromino_shapes[static_cast<int> (
+      p_tetromino_instance.m_tetromino_type)][p_tetromino_instance.m_rotation];
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      if (!shape.row_masks[i])
+        continue;
+      const auto y = p_tetromino_instance.m_pos.y + static_cast<int> (i);
+      const auto depth = get_depth (p_board, y);
+      const auto slot = find_slot (p_board, depth);
+      p_board.slot_hashes[slot] = hash_row (
+          p_board, &p_board.slot_rows[slot * p_board.row_words]);
+      pull_path (p_board, p_board.root, depth);
+    }
+  p_board.hash = get_subtree_hash (p_board, p_board.root);
+  ++p_board.revision;
+}
+
+/**@brief Remove the full rows among the given ones
+ *
+ * Only the given rows (those touched by the last locked tetromino) are
+ * checked. Cleared rows are cut out of the tree, the rows above them fall
+ * without being moved and the board hash is read from the new root. The
+ * columns whose top was cleared are searched down from there, the others
+ * only move down by the rows cleared under them.
+ *
+ * @param board from which the rows are removed.
+ * @param first row to check, may be outside of the board.
+ * @param number of rows to check, at most tetromino::block_num.
+ * @return the rows that were removed.
+ */
+auto
+clear_full_rows (dynamic_board &p_board, int first_row, unsigned int row_num)
+    -> line_clear_result
+{
+  line_clear_result result = {};
+
+  const auto begin = std::max (first_row, 0);
+  const auto end = std::min (first_row + static_cast<int> (row_num),
+                             static_cast<int> (p_board.height));
+  for (auto y = begin; y < end; ++y)
+    {
+      if (is_row_full (p_board, y))
+        result.rows[result.count++] = y;
+    }
+  if (!result.count)
+    return result;
+
+  auto is_cleared = [&result] (unsigned int y) {
+    for (auto i = 0u; i < result.count; ++i)
+      {
+        if (result.rows[i] == y)
+          return true;
+      }
+    return false;
+  };
+  auto cleared_below = [&result] (unsigned int y) {
+    auto count = 0u;
+    for (auto i = 0u; i < result.count; ++i)
+      count += result.rows[i] > y;
+    return count;
+  };
+
+  for (auto x = 0u; x < p_board.width; ++x)
+    {
+      auto y = static_cast<unsigned int> (p_board.column_tops[x]);
+      if (y >= p_board.height)
+        continue;
+      if (is_cleared (y))
+        {
+          while (y < p_board.height
+                 && (is_cleared (y) || !is_filled (p_board, x, y)))
+            ++y;
+        }
+      p_board.column_tops[x]
+          = y < p_board.height ? y + cleared_below (y) : p_board.height;
+    }
+
+  // top to bottom, so that the depths of the rows left to cut don't change
+  for (auto i = 0u; i < result.count; ++i)
+    {
+      uint32_t lower, cleared, upper;
+      split (p_board, p_board.root, get_depth (p_board, result.rows[i]),
+             lower, upper);
+      split (p_board, upper, 1, cleared, upper);
+      p_board.root = merge (p_board, lower, upper);
+      free_slot (p_board, cleared);
+    }
+  p_board.hash = get_subtree_hash (p_board, p_board.root);
+  ++p_board.revision;
+  return result;
+}
+
+/**@brief check for colisions on the board
+ *
+ * Each row of the tetromino is shifted in place and tested against the one
+ * or two words of the board row it falls in, the rows above the stack are
+ * only walls.
+ *
+ * @param Tetromino instance whose colisions need to be checked.
+ * @param board against which the collisions need to be checked.
+ * @return true if the given tetromino would collide with the board, false
+ * otherwise.
+ */
+auto
+is_overlap (const tetromino_instance &p_instance, const dynamic_board &p_board)
+    -> bool
+{
+  const auto &shape
+      = tetromino_shapes[static_cast<int> (p_instance.m_tetromino_type)]
+                        [p_instance.m_rotation];
+
+  const auto shift = p_instance.m_pos.x + board_base::wall_bits;
+  if (shift < 0
+      || shift > static_cast<int> (p_board.row_words
+                                       * dynamic_board::word_bits
+                                   - tetromino::block_num))
+    return true;
+  const auto index = shift / dynamic_board::word_bits;
+  const auto bit = shift % dynamic_board::word_bits;
+
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const auto mask = static_cast<word> (shape.row_masks[i]);
+      if (!mask)
+        continue;
+
+      const auto y = p_instance.m_pos.y + static_cast<int> (i);
+      if (y < 0 || y >= static_cast<int> (p_board.height))
+        return true;
+      const auto *row = get_row (p_board, y);
+      if (row[index] & mask << bit)
+        return true;
+      // the box straddles two words
+      constexpr auto last_bit
+          = dynamic_board::word_bits - static_cast<int> (tetromino::block_num);
+      if (bit > last_bit
+          && row[index + 1] & mask >> (dynamic_board::word_bits - bit))
+        return true;
+    }
+  return false;
+}
+
+/**@brief get the static block at the given cell
+ *
+ * @param board to be read
+ * @param column of the cell
+ * @param row of the cell
+ * @return index of the tetromino type the block came from, -1 if the cell is
+ * empty.
+ */
+auto
+get_block (const dynamic_board &p_board, unsigned int x, unsigned int y)
+    -> int
+{
+  const auto depth = get_depth (p_board, y);
+  if (depth >= get_stored_rows (p_board))
+    return -1;
+  const auto color
+      = p_board.slot_colors[find_slot (p_board, depth) * p_board.width + x];
+  return color == board_base::empty_cell ? -1 : color;
+}
+
+/**@brief check if every cell of a row is filled
+ */
+auto
+is_row_full (const dynamic_board &p_board, unsigned int y) -> bool
+{
+  const auto *row = get_row (p_board, y);
+  return std::all_of (row, row + p_board.row_words,
+                      [] (word bits) { return bits == ~word (0); });
+}
@@ -0,0 +1,513 @@
+/**@file board.hpp
+ * @brief contains the playing board and collision checks
+ *
+ * The board is stored as a bitboard: one word per row with a bit per cell,
+ * the walls on both sides are pre-set so that collisions with the walls and
+ * with static blocks are found with the same AND operation. The color of
+ * every static block is kept in a separate plane used for rendering.
+ *
+ * The board also keeps a 64 bit hash of its filled cells, updated with the
+ * rows touched by every lock and line clear instead of being recomputed. It
+ * is a sum of per row hashes weighted by per row factors, so a row changing
+ * only costs a subtraction and an addition.
+ *
+ * The size of the board is a template parameter: a board of a known size
+ * (board, the 10x20 board of the game) is stored in fixed arrays, every loop
+ * and bounds check of its rules is resolved at compile time and copying it
+ * never allocates. The dynamic_board is sized at run time for stress tests
+ * and variants, hundreds of columns wide and thousands of rows high: its rows
+ * are several words long and only the rows from the bottom up to the
+ * highest block are stored, the empty rows above them cost nothing. A lock
+ * or a line clear costs its rows, each found in O(log rows). Its rules are
+ * in board.cpp.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "rng.hpp"
+#include "tetromino.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+using board_row = uint32_t;
+
+/** size of a board dimension chosen at run time */
+static constexpr auto dynamic_size = 0u;
+
+/**@brief what every board size has in common
+ */
+struct board_base
+{
+  // sentinel columns on the left of the board, wide enough for any shifted
+  // tetromino box to stay in range
+  static constexpr auto wall_bits = 4;
+  static constexpr auto max_width
+      = static_cast<unsigned int> (sizeof (board_row) * 8 - 2 * wall_bits);
+  static constexpr uint8_t empty_cell = 0xff;
+};
+
+/**@brief board of a size known at compile time, a row fits in a board_row
+ */
+template <unsigned int Width, unsigned int Height>
+struct basic_board : board_base
+{
+  static_assert (Width > 0 && Width <= max_width,
+                 "a row of the board must fit in a board_row");
+  static_assert (Height > 0, "the board needs at least a row");
+
+  static constexpr auto width = Width;
+  static constexpr auto height = Height;
+  static constexpr board_row full_row = ~board_row (0); // every bit set
+  static constexpr board_row empty_row // only the walls
+      = full_row & ~(((board_row (1) << Width) - 1) << wall_bits);
+
+  std::array<board_row, Height> rows = {}; // bit wall_bits + x is set if
+                                           // (x, y) is filled
+  std::array<uint8_t, Width * Height> colors = {}; // tetromino type of each
+                                                   // cell or empty_cell
+  std::array<int, Width> column_tops = {}; // highest filled row of each
+                                           // column, height if it is empty
+  unsigned int revision = 0; // bumped every time the static blocks change
+  std::array<uint64_t, Height> row_hashes = {}; // hash of the filled cells
+                                                // of each row, 0 if empty
+  uint64_t hash = 0; // sum of row_hashes[y] * get_row_factor (y), 0 if empty
+};
+
+/**@brief board of a size chosen at run time (see reset_board ())
+ *
+ * Rows are row_words 64 bit words, bit wall_bits + x of a row is set if
+ * (x, y) is filled. Rows are stored in slots, from the bottom one
+ * (height - 1) up to the highest block, the rows above them are empty and
+ * not stored. Cleared rows give their slot back for the next rows, so the
+ * memory is that of the highest stack the board had.
+ *
+ * The slots are the nodes of a tree ordered by depth (an implicit treap),
+ * every node keeps the weighted hash of its subtree: finding, adding and
+ * removing a row costs O(log rows) whatever its depth, and the rows above a
+ * cleared one fall without being moved or hashed again.
+ */
+template <> struct basic_board<dynamic_size, dynamic_size> : board_base
+{
+  using word = uint64_t;
+  static constexpr auto word_bits = static_cast<int> (sizeof (word) * 8);
+  static constexpr auto no_slot = ~uint32_t (0);
+
+  /**@brief a stored row in the tree, the rows below it are on the left
+   */
+  struct node
+  {
+    uint32_t left;  // slot of the lower subtree, no_slot if empty
+    uint32_t right; // slot of the upper subtree, no_slot if empty
+    uint32_t size;  // rows of the subtree
+    uint64_t hash;  // row hashes of the subtree * depth_weights[depth in
+                    // the subtree]
+  };
+
+  unsigned int width = 0;
+  unsigned int height = 0;
+  unsigned int row_words = 0; // walls included, at least wall_bits on the
+                              // right
+  std::vector<word> empty_row;  // only the walls
+  uint32_t root = no_slot; // slot of the root of the stored rows
+  std::vector<uint32_t> free_slots;
+  std::vector<word> slot_rows;     // row_words words per slot
+  std::vector<uint8_t> slot_colors; // width cells per slot, tetromino type
+                                    // or empty_cell
+  std::vector<uint64_t> slot_hashes; // hash of the filled cells of the row
+  std::vector<node> slot_nodes;
+  std::vector<uint64_t> depth_weights; // odd weight of a row hash at every
+                                       // depth, one more than the slots
+  std::vector<int> column_tops; // highest filled row of each column, height
+                                // if the column is empty
+  unsigned int revision = 0; // bumped every time the static blocks change
+  uint64_t hash = 0; // sum of the row hashes * depth_weights[depth], 0 if
+                     // empty
+};
+
+using board = basic_board<10, 20>;
+using dynamic_board = basic_board<dynamic_size, dynamic_size>;
+
+/**@brief rows removed from the board by a single line clear
+ */
+struct line_clear_result
+{
+  unsigned int rows[tetromino::block_num]; // indices before the clear, top
+                                           // to bottom
+  unsigned int count;
+};
+
+/**@brief odd weight of a row in the board hash, distinct for every row
+ */
+constexpr auto
+get_row_factor (unsigned int y) -> uint64_t
+{
+  return (2 * uint64_t (y) + 1) * 0x9e3779b97f4a7c15ull;
+}
+
+/**@brief hash the filled cells of a row
+ *
+ * @param board the row belongs to
+ * @param row bits, walls included
+ * @return hash of the row, 0 if it has no filled cell
+ */
+template <unsigned int Width, unsigned int Height>
+inline auto
+hash_row (const basic_board<Width, Height> &p_board, board_row row)
+    -> uint64_t
+{
+  return fmix64 (row ^ p_board.empty_row);
+}
+
+/**@brief get the static block at the given cell
+ *
+ * @param board to be read
+ * @param column of the cell
+ * @param row of the cell
+ * @return index of the tetromino type the block came from, -1 if the cell is
+ * empty.
+ */
+template <unsigned int Width, unsigned int Height>
+inline auto
+get_block (const basic_board<Width, Height> &p_board, unsigned int x,
+           unsigned int y) -> int
+{
+  const auto color = p_board.colors[y * Width + x];
+  return color == board_base::empty_cell ? -1 : color;
+}
+
+/**@brief check if every cell of a row is filled
+ */
+template <unsigned int Width, unsigned int Height>
+inline auto
+is_row_full (const basic_board<Width, Height> &p_board, unsigned int y)
+    -> bool
+{
+  return p_board.rows[y] == p_board.full_row;
+}
+
+/**@brief check for colisions on the board
+ *
+ * check if the given isntanc of tetormino would collide with the board or not.
+ * Each row of the tetromino is shifted in place and tested against the
+ * board row with a single AND, walls are part of the board rows, the area
+ * above and below the board counts as filled.
+ *
+ * @param Tetromino instance whose colisions need to be checked.
+ * @param Instanc of board against which the collisions need to be checked.
+ * @return true if the given tetromino would collide with the board, false
+ * otherwise.
+ */
+template <unsigned int Width, unsigned int Height>
+inline auto
+is_overlap (const tetromino_instance &p_instance,
+            const basic_board<Width, Height> &p_board) -> bool
+{
+  const auto &shape
+      = tetromino_shapes[static_cast<int> (p_instance.m_tetromino_type)]
+                        [p_instance.m_rotation];
+
+  // every block left of the wall sentinels (or past the top bits of a row)
+  // is off the board
+  const auto shift = p_instance.m_pos.x + board_base::wall_bits;
+  if (shift < 0
+      || shift > static_cast<int> (sizeof (board_row) * 8 - tetromino::block_num))
+    return true;
+
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const board_row mask = static_cast<board_row> (shape.row_masks[i])
+                             << shift;
+      if (!mask)
+        continue;
+
+      const auto y = p_instance.m_pos.y + static_cast<int> (i);
+      if (y < 0 || y >= static_cast<int> (Height))
+        return true;
+      if (p_board.rows[y] & mask)
+        return true;
+    }
+  return false;
+}
+
+/**@brief Remove every static block from the board
+ */
+template <unsigned int Width, unsigned int Height>
+auto
+clear_board (basic_board<Width, Height> &p_board) -> void
+{
+  p_board.rows.fill (p_board.empty_row);
+  p_board.colors.fill (board_base::empty_cell);
+  p_board.column_tops.fill (static_cast<int> (Height));
+  p_board.row_hashes.fill (0);
+  p_board.hash = 0;
+  ++p_board.revision;
+}
+
+/**@brief Recompute the hash of the board from its rows
+ *
+ * Only needed after the rows were changed directly, lock_tetromino and
+ * clear_full_rows keep the hash up to date.
+ *
+ * @param board to be hashed
+ * @return void
+ */
+template <unsigned int Width, unsigned int Height>
+auto
+rehash_board (basic_board<Width, Height> &p_board) -> void
+{
+  p_board.hash = 0;
+  for (auto y = 0u; y < Height; ++y)
+    {
+      p_board.row_hashes[y] = hash_row (p_board, p_board.rows[y]);
+      p_board.hash += p_board.row_hashes[y] * get_row_factor (y);
+    }
+}
+
+/**@brief Turn the blocks of a tetromino into static blocks of the board
+ *
+ * @param board on which the tetromino is locked.
+ * @param instance of the tetromino to be locked, it must not overlap.
+ * @return void
+ */
+template <unsigned int Width, unsigned int Height>
+auto
+lock_tetromino (basic_board<Width, Height> &p_board,
+                const tetromino_instance &p_tetromino_instance) -> void
+{
+  const auto &tet = tetromino_data[static_cast<int> (
+      p_tetromino_instance.m_tetromino_type)];
+  const auto &block_coords = tet.block_coords[p_tetromino_instance.m_rotation];
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const int x = p_tetromino_instance.m_pos.x + block_coords[i].x;
+      const int y = p_tetromino_instance.m_pos.y + block_coords[i].y;
+
+      // TODO: assert that tetromino doesn't go out of board
+
+      p_board.rows[y] |= board_row (1) << (x + board_base::wall_bits);
+      p_board.colors[x + y * Width]
+          = static_cast<uint8_t> (p_tetromino_instance.m_tetromino_type);
+      p_board.column_tops[x] = std::min (p_board.column_tops[x], y);
+    }
+
+  const auto &shape = tetromino_shapes[static_cast<int> (
+      p_tetromino_instance.m_tetromino_type)][p_tetromino_instance.m_rotation];
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      if (!shape.row_masks[i])
+        continue;
+      const auto y = p_tetromino_instance.m_pos.y + static_cast<int> (i);
+      const auto row_hash = hash_row (p_board, p_board.rows[y]);
+      p_board.hash
+          += (row_hash - p_board.row_hashes[y]) * get_row_factor (y);
+      p_board.row_hashes[y] = row_hash;
+    }
+  ++p_board.revision;
+}
+
+/**@brief Recompute the column heights after rows were removed
+ *
+ * Blocks only move down when rows are removed, so the search starts at the
+ * previously highest block and resolves every column of a row at once.
+ *
+ * @param board whose column heights are updated.
+ * @return void
+ */
+template <unsigned int Width, unsigned int Height>
+auto
+update_column_tops (basic_board<Width, Height> &p_board) -> void
+{
+  const auto first_row = *std::min_element (p_board.column_tops.begin (),
+                                            p_board.column_tops.end ());
+  auto unresolved = ~p_board.empty_row;
+  p_board.column_tops.fill (static_cast<int> (Height));
+
+  for (auto y = first_row; y < static_cast<int> (Height) && unresolved; ++y)
+    {
+      auto found = p_board.rows[y] & unresolved;
+      unresolved &= ~found;
+      for (; found; found &= found - 1)
+        {
+          const auto x = __builtin_ctz (found) - board_base::wall_bits;
+          p_board.column_tops[x] = y;
+        }
+    }
+}
+
+/**@brief Remove the full rows among the given ones
+ *
+ * Only the given rows (those touched by the last locked tetromino) are
+ * checked. Surviving rows of that range are compacted in a single bottom up
+ * pass, the untouched rows above it are moved down with one block move.
+ *
+ * @param board from which the rows are removed.
+ * @param first row to check, may be outside of the board.
+ * @param number of rows to check, at most tetromino::block_num.
+ * @return the rows that were removed.
+ */
+template <unsigned int Width, unsigned int Height>
+auto
+clear_full_rows (basic_board<Width, Height> &p_board, int first_row,
+                 unsigned int row_num) -> line_clear_result
+{
+  line_clear_result result = {};
+
+  const auto begin = std::max (first_row, 0);
+  const auto end = std::min (first_row + static_cast<int> (row_num),
+                             static_cast<int> (Height));
+  for (auto y = begin; y < end; ++y)
+    {
+      if (is_row_full (p_board, y))
+        result.rows[result.count++] = y;
+    }
+  if (!result.count)
+    return result;
+
+  // rows move between the highest block and the lowest cleared row, take
+  // their weighted hashes out of the board hash before and put them back
+  // after the move
+  const auto stack_top = *std::min_element (p_board.column_tops.begin (),
+                                            p_board.column_tops.end ());
+  const auto lowest = static_cast<int> (result.rows[result.count - 1]);
+  for (auto y = stack_top; y <= lowest; ++y)
+    p_board.hash -= p_board.row_hashes[y] * get_row_factor (y);
+
+  auto move_rows = [&p_board] (unsigned int dst, unsigned int src,
+                               unsigned int num) {
+    std::memmove (&p_board.rows[dst], &p_board.rows[src],
+                  num * sizeof (board_row));
+    std::memmove (&p_board.row_hashes[dst], &p_board.row_hashes[src],
+                  num * sizeof (uint64_t));
+    std::memmove (&p_board.colors[dst * Width], &p_board.colors[src * Width],
+                  num * Width);
+  };
+
+  // compact the touched range, starting right above the lowest full row
+  auto dst = lowest;
+  auto next_full = static_cast<int> (result.count) - 2;
+  for (auto src = dst - 1; src >= begin; --src)
+    {
+      if (next_full >= 0 && static_cast<int> (result.rows[next_full]) == src)
+        {
+          --next_full;
+          continue;
+        }
+      move_rows (dst--, src, 1);
+    }
+
+  // everything above the touched range falls by the number of cleared rows
+  move_rows (result.count, 0, begin);
+  std::fill_n (p_board.rows.begin (), result.count, p_board.empty_row);
+  std::fill_n (p_board.colors.begin (), result.count * Width,
+               board_base::empty_cell);
+  std::fill_n (p_board.row_hashes.begin (), result.count, 0);
+  for (auto y = stack_top; y <= lowest; ++y)
+    p_board.hash += p_board.row_hashes[y] * get_row_factor (y);
+  update_column_tops (p_board);
+  ++p_board.revision;
+  return result;
+}
+
+auto reset_board (dynamic_board &p_board, unsigned int width,
+                  unsigned int height) -> void;
+auto clear_board (dynamic_board &p_board) -> void;
+auto get_stored_rows (const dynamic_board &p_board) -> unsigned int;
+auto rehash_board (dynamic_board &p_board) -> void;
+auto lock_tetromino (dynamic_board &p_board,
+                     const tetromino_instance &p_tetromino_instance) -> void;
+auto clear_full_rows (dynamic_board &p_board, int first_row,
+                      unsigned int row_num) -> line_clear_result;
+auto is_overlap (const tetromino_instance &p_instance,
+                 const dynamic_board &p_board) -> bool;
+auto get_block (const dynamic_board &p_board, unsigned int x, unsigned int y)
+    -> int;
+auto is_row_full (const dynamic_board &p_board, unsigned int y) -> bool;
+
+/**@brief find how far a tetromino can fall
+ *
+ * When every block of the tetromino is above the highest filled cell of its
+ * column, the distance is read from the column heights. Otherwise (tucked
+ * under an overhang) the tetromino is moved down one row at a time.
+ *
+ * @param tetromino instance that falls, it must not overlap the board.
+ * @param board on which the tetromino falls.
+ * @return number of rows the tetromino can move down.
+ */
+template <typename board_type>
+inline auto
+drop_distance (const tetromino_instance &p_instance,
+               const board_type &p_board) -> int
+{
+  const auto &shape
+      = tetromino_shapes[static_cast<int> (p_instance.m_tetromino_type)]
+                        [p_instance.m_rotation];
+
+  auto distance = static_cast<int> (p_board.height);
+  auto above_skyline = true;
+  for (auto i = 0u; i < tetromino::block_num && above_skyline; ++i)
+    {
+      if (shape.column_bottoms[i] < 0)
+        continue;
+
+      const auto x = p_instance.m_pos.x + static_cast<int> (i);
+      if (x < 0 || x >= static_cast<int> (p_board.width))
+        {
+          above_skyline = false;
+          break;
+        }
+      const auto bottom = p_instance.m_pos.y + shape.column_bottoms[i];
+      const auto column_distance = p_board.column_tops[x] - 1 - bottom;
+      if (column_distance < 0)
+        above_skyline = false;
+      else if (column_distance < distance)
+        distance = column_distance;
+    }
+  if (above_skyline)
+    return distance;
+
+  auto temp_instance = p_instance;
+  do
+    {
+      ++temp_instance.m_pos.y;
+    }
+  while (!is_overlap (temp_instance, p_board));
+  return temp_instance.m_pos.y - 1 - p_instance.m_pos.y;
+}
+
+/**@brief rotate a tetromino, kicking it one column aside if needed
+ *
+ * The rotated tetromino is tried in place, then one column to the left, then
+ * one column to the right. (FIXME: SRS can kick the *I* block two columns)
+ *
+ * @param tetromino instance to be rotated, left unchanged if no position fits
+ * @param board on which the tetromino is rotated.
+ * @param true to rotate clockwise, false to rotate anticlockwise.
+ * @return true if the tetromino was rotated, false otherwise.
+ */
+template <typename board_type>
+inline auto
+rotate_tetromino (tetromino_instance &p_instance, const board_type &p_board,
+                  bool clockwise) -> bool
+{
+  auto temp_instance = p_instance;
+  temp_instance.m_rotation
+      = (temp_instance.m_rotation
+         + (clockwise ? tetromino::rotation_num - 1 : 1))
+        % tetromino::rotation_num;
+  for (auto kick : { 0, -1, 1 })
+    {
+      temp_instance.m_pos.x = p_instance.m_pos.x + kick;
+      if (!is_overlap (temp_instance, p_board))
+        {
+          p_instance = temp_instance;
+          return true;
+        }
+    }
+  return false;
+}
+
+#endif /* BOARD_H */
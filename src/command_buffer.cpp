@@ -0,0 +1,220 @@
+/**@file command_buffer.cpp
+ * @brief contains the recording, comparison and submission of draw commands
+ *
+ */
+
+#include "command_buffer.hpp"
+#include "renderer.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+/**@brief Constructor of command_buffer class
+ */
+command_buffer::command_buffer () : m_changed (false) {}
+
+/**@brief Drop every command, the storage is kept for the next frame
+ */
+auto
+command_buffer::clear () -> void
+{
+  m_commands.clear ();
+  m_text.clear ();
+  m_changed = false;
+}
+
+/**@brief Append a command, commands past max_commands are dropped
+ */
+auto
+command_buffer::push (const render_command &command) -> void
+{
+  if (m_commands.size () < max_commands)
+    m_commands.push_back (command);
+}
+
+/**@brief Record a copy of a layer of the renderer
+ *
+ * The contents of the layer are not part of the command, whoever redraws the
+ * layer must call mark_changed ().
+ *
+ * @param depth of the command
+ * @param handle of the layer
+ * @param location of the top left corner of the layer
+ * @return void
+ */
+auto
+command_buffer::draw_layer (unsigned char depth, int layer, const coords loc)
+    -> void
+{
+  push ({ render_command_type::layer, depth, block_sprite::filled, loc, 0, 0,
+          0, static_cast<uint32_t> (layer) });
+}
+
+/**@brief Record a filled rectangle
+ *
+ * @param depth of the command
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgba)
+ * @return void
+ */
+auto
+command_buffer::draw_filled_rectangle (unsigned char depth, const coords loc,
+                                       int width, int height,
+                                       uint32_t rgba_color) -> void
+{
+  push ({ render_command_type::filled_rect, depth, block_sprite::filled, loc,
+          width, height, rgba_color, 0 });
+}
+
+/**@brief Record the outline of a rectangle
+ *
+ * @param depth of the command
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgba)
+ * @return void
+ */
+auto
+command_buffer::draw_rectangle (unsigned char depth, const coords loc,
+                                int width, int height, uint32_t rgba_color)
+    -> void
+{
+  push ({ render_command_type::rect, depth, block_sprite::filled, loc, width,
+          height, rgba_color, 0 });
+}
+
+/**@brief Record a block
+ *
+ * @param depth of the command
+ * @param block to be drawn
+ * @return void
+ */
+auto
+command_buffer::draw_block (unsigned char depth, const block_quad &block)
+    -> void
+{
+  push ({ render_command_type::block, depth, block.sprite, block.loc,
+          block.size, block.size, block.rgba_color, 0 });
+}
+
+/**@brief Record a string, it is copied into the buffer
+ *
+ * @param depth of the command
+ * @param null terminated string to be drawn
+ * @param location of the text
+ * @param color of the text (rgba)
+ * @return void
+ */
+auto
+command_buffer::draw_text (unsigned char depth, const char *text,
+                           const coords loc, uint32_t rgba_color) -> void
+{
+  const auto offset = static_cast<uint32_t> (m_text.size ());
+  m_text.insert (m_text.end (), text, text + std::strlen (text) + 1);
+  push ({ render_command_type::text, depth, block_sprite::filled, loc, 0, 0,
+          rgba_color, offset });
+}
+
+/**@brief Tell that something the commands refer to (a layer) was redrawn,
+ * the buffer then never compares equal to another one
+ */
+auto
+command_buffer::mark_changed () -> void
+{
+  m_changed = true;
+}
+
+/**@brief Check if two buffers would draw the same frame
+ *
+ * @param buffer to compare with, usually the previous frame
+ * @return true if both buffers hold the same commands and strings and
+ * neither was marked as changed, false otherwise
+ */
+auto
+command_buffer::is_same (const command_buffer &other) const -> bool
+{
+  TRACE_ZONE ("command_buffer::is_same");
+  return !m_changed && !other.m_changed && m_commands == other.m_commands
+         && m_text == other.m_text;
+}
+
+/**@brief Sort the commands and submit them to the renderer
+ *
+ * Commands are ordered by depth, then type, then color (except blocks, which
+ * are batched whatever their color). The original index
+ * is the last part of the sort key so equal commands keep their order and
+ * no stable sort (and its temporary buffer) is needed. Consecutive
+ * rectangles and blocks are then submitted as single batches.
+ *
+ * @param renderer the commands are drawn with
+ * @return void
+ */
+auto
+command_buffer::submit (renderer &p_renderer) -> void
+{
+  TRACE_ZONE ("command_buffer::submit");
+  m_sort_keys.clear ();
+  for (auto i = 0u; i < m_commands.size (); ++i)
+    {
+      const auto &command = m_commands[i];
+      // blocks of every color go in the same batch, their order is kept
+      const auto color = command.type == render_command_type::block
+                             ? 0
+                             : command.rgba_color;
+      m_sort_keys.push_back (uint64_t (command.depth) << 56
+                             | uint64_t (command.type) << 48
+                             | uint64_t (color) << 16 | i);
+    }
+  // frames are mostly recorded in order already
+  if (!std::is_sorted (m_sort_keys.begin (), m_sort_keys.end ()))
+    std::sort (m_sort_keys.begin (), m_sort_keys.end ());
+
+  auto flush_batches = [&] () {
+    if (!m_rect_batch.empty ())
+      p_renderer.draw_filled_rectangles (m_rect_batch.data (),
+                                         m_rect_batch.size ());
+    if (!m_block_batch.empty ())
+      p_renderer.draw_blocks (m_block_batch.data (), m_block_batch.size ());
+    m_rect_batch.clear ();
+    m_block_batch.clear ();
+  };
+
+  for (const auto key : m_sort_keys)
+    {
+      const auto &command = m_commands[key & 0xffff];
+      switch (command.type)
+        {
+        case render_command_type::filled_rect:
+          if (!m_block_batch.empty ())
+            flush_batches ();
+          m_rect_batch.push_back ({ command.loc, command.width, command.height,
+                                    command.rgba_color });
+          break;
+        case render_command_type::block:
+          if (!m_rect_batch.empty ())
+            flush_batches ();
+          m_block_batch.push_back ({ command.loc, command.width,
+                                     command.rgba_color, command.sprite });
+          break;
+        case render_command_type::rect:
+          flush_batches ();
+          p_renderer.draw_rectangle (command.loc, command.width,
+                                     command.height, command.rgba_color);
+          break;
+        case render_command_type::text:
+          flush_batches ();
+          p_renderer.draw_text (&m_text[command.data], command.loc,
+                                command.rgba_color);
+          break;
+        case render_command_type::layer:
+          flush_batches ();
+          p_renderer.draw_layer (static_cast<int> (command.data),
+                                 command.loc);
+          break;
+        }
+    }
+  flush_batches ();
+}
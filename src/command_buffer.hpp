@@ -0,0 +1,103 @@
+/**@file command_buffer.hpp
+ * @brief contains the retained list of draw commands of a frame
+ *
+ * game_renderer and the overlays record what a frame draws into a
+ * command_buffer instead of calling the renderer right away. Every command
+ * has a depth: commands are submitted by increasing depth, and commands of
+ * the same depth must not overlap so that they can be reordered freely.
+ * Within a depth they are sorted by type and color before submission, then
+ * runs of rectangles and of blocks are merged into single batched calls, so
+ * the backend changes its state as few times as possible.
+ *
+ * A frame recorded into a second buffer can be compared with the previous
+ * one, if nothing changed the frame doesn't need to be submitted at all.
+ */
+
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include "utils.hpp"
+#include <cstddef>
+#include <vector>
+
+class renderer;
+
+enum class render_command_type : unsigned char
+{
+  layer,
+  filled_rect,
+  rect,
+  block,
+  text,
+};
+
+/**@brief a single draw command, plain data so that frames compare cheaply
+ */
+struct render_command
+{
+  render_command_type type;
+  unsigned char depth;
+  block_sprite sprite; // blocks only
+  coords loc;
+  int width;
+  int height;
+  uint32_t rgba_color;
+  uint32_t data; // text: offset in the text storage, layer: handle
+
+  auto
+  operator== (const render_command &other) const -> bool
+  {
+    return type == other.type && depth == other.depth
+           && sprite == other.sprite && loc.x == other.loc.x
+           && loc.y == other.loc.y && width == other.width
+           && height == other.height && rgba_color == other.rgba_color
+           && data == other.data;
+  }
+};
+
+class command_buffer
+{
+public:
+  // the submission order of equal commands is kept by sorting on their
+  // index, frames can't hold more commands than that
+  static constexpr auto max_commands = 0x10000u;
+
+  command_buffer ();
+
+  auto clear () -> void;
+
+  auto draw_layer (unsigned char depth, int layer, const coords loc) -> void;
+  auto draw_filled_rectangle (unsigned char depth, const coords loc,
+                              int width, int height, uint32_t rgba_color)
+      -> void;
+  auto draw_rectangle (unsigned char depth, const coords loc, int width,
+                       int height, uint32_t rgba_color) -> void;
+  auto draw_block (unsigned char depth, const block_quad &block) -> void;
+  auto draw_text (unsigned char depth, const char *text, const coords loc,
+                  uint32_t rgba_color) -> void;
+
+  auto mark_changed () -> void;
+  auto is_same (const command_buffer &other) const -> bool;
+  auto submit (renderer &p_renderer) -> void;
+
+  // getters
+  auto
+  get_size () const
+  {
+    return m_commands.size ();
+  }
+
+private:
+  auto push (const render_command &command) -> void;
+
+  std::vector<render_command> m_commands;
+  std::vector<char> m_text; // null terminated strings of the text commands
+  bool m_changed; // something drawn outside of the commands changed
+
+  // storage reused by submit ()
+  std::vector<uint64_t> m_sort_keys;
+  std::vector<colored_rect> m_rect_batch;
+  std::vector<block_quad> m_block_batch;
+};
+
+#endif /* COMMAND_BUFFER_H */
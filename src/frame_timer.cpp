@@ -0,0 +1,167 @@
+/**@file frame_timer.cpp
+ * @brief contains functions that measure the phases of every frame.
+ *
+ */
+
+#include "frame_timer.hpp"
+#include <algorithm>
+#include <cstdio>
+
+static const char *const phase_names[]
+    = { "input", "update", "draw", "present" };
+static_assert (sizeof (phase_names) / sizeof (phase_names[0])
+                   == static_cast<int> (frame_phase::count),
+               "every frame phase needs a name");
+
+/**@brief Constructor of frame_timer class
+ */
+frame_timer::frame_timer ()
+    : m_samples (), m_frame_num (0), m_current (), m_in_frame (false),
+      m_sort_scratch ()
+{
+}
+
+/**@brief Start timing a new frame
+ *
+ * The previous frame (if any) is completed and stored in the ring buffer, its
+ * duration runs up to now so time spent outside of the phases (waiting for
+ * the next frame) is included.
+ *
+ * @return void
+ */
+auto
+frame_timer::begin_frame () -> void
+{
+  const auto now = clock::now ();
+  if (m_in_frame)
+    {
+      m_current.frame_ms
+          = std::chrono::duration<float, std::milli> (now - m_frame_start)
+                .count ();
+      m_samples[m_frame_num % capacity] = m_current;
+      ++m_frame_num;
+    }
+  m_current = {};
+  m_frame_start = now;
+  m_phase_start = now;
+  m_in_frame = true;
+}
+
+/**@brief Mark the end of a phase of the current frame
+ *
+ * The phase lasted from the end of the previous phase (or the start of the
+ * frame) until now. A phase that ends more than once per frame accumulates.
+ *
+ * @param phase that just ended
+ * @return void
+ */
+auto
+frame_timer::end_phase (frame_phase phase) -> void
+{
+  const auto now = clock::now ();
+  m_current.phase_ms[static_cast<int> (phase)]
+      += std::chrono::duration<float, std::milli> (now - m_phase_start)
+             .count ();
+  m_phase_start = now;
+}
+
+/**@brief Record how many simulation steps the current frame ran
+ */
+auto
+frame_timer::set_steps (uint32_t steps) -> void
+{
+  m_current.steps = steps;
+}
+
+/**@brief Record how many heap allocations the current frame made
+ */
+auto
+frame_timer::set_allocations (uint32_t allocations) -> void
+{
+  m_current.allocations = allocations;
+}
+
+/**@brief Get a stored frame, 0 being the oldest one in the ring buffer
+ */
+auto
+frame_timer::sample_at (unsigned int index) const -> const frame_sample &
+{
+  const auto first = m_frame_num > capacity ? m_frame_num - capacity : 0;
+  return m_samples[(first + index) % capacity];
+}
+
+/**@brief Compute frame rate, frame time percentiles and average phase times
+ * over the frames in the ring buffer
+ *
+ * @return statistics of the stored frames, all zero if there are none yet
+ */
+auto
+frame_timer::summarize () const -> frame_summary
+{
+  frame_summary summary = {};
+  summary.frame_num = static_cast<unsigned int> (
+      std::min<unsigned long> (m_frame_num, capacity));
+  if (!summary.frame_num)
+    return summary;
+
+  auto total_ms = 0.0f;
+  for (auto i = 0u; i < summary.frame_num; ++i)
+    {
+      const auto &sample = sample_at (i);
+      total_ms += sample.frame_ms;
+      for (auto phase = 0; phase < static_cast<int> (frame_phase::count);
+           ++phase)
+        summary.phase_ms[phase] += sample.phase_ms[phase];
+      m_sort_scratch[i] = sample.frame_ms;
+      summary.max_allocations
+          = std::max (summary.max_allocations, sample.allocations);
+    }
+  for (auto &phase_ms : summary.phase_ms)
+    phase_ms /= summary.frame_num;
+  summary.fps = total_ms > 0.0f ? 1000.0f * summary.frame_num / total_ms : 0;
+
+  // nearest rank percentiles
+  const auto begin = m_sort_scratch.begin ();
+  const auto end = begin + summary.frame_num;
+  auto percentile = [begin, end, &summary] (unsigned int percent) {
+    const auto rank = (summary.frame_num * percent + 99) / 100;
+    const auto nth = begin + (rank ? rank - 1 : 0);
+    std::nth_element (begin, nth, end);
+    return *nth;
+  };
+  summary.p50_ms = percentile (50);
+  summary.p99_ms = percentile (99);
+  summary.max_ms = *std::max_element (begin, end);
+  return summary;
+}
+
+/**@brief Write the frames in the ring buffer to a CSV file, oldest first
+ *
+ * @param path of the file to be written
+ * @return true if the file was written, false otherwise
+ */
+auto
+frame_timer::write_csv (const char *path) const -> bool
+{
+  auto *file = fopen (path, "w");
+  if (!file)
+    return false;
+
+  fprintf (file, "frame,frame_ms");
+  for (auto *name : phase_names)
+    fprintf (file, ",%s_ms", name);
+  fprintf (file, ",steps,allocations\n");
+
+  const auto frame_num = std::min<unsigned long> (m_frame_num, capacity);
+  const auto first = m_frame_num - frame_num;
+  for (auto i = 0u; i < frame_num; ++i)
+    {
+      const auto &sample = sample_at (i);
+      fprintf (file, "%lu,%.3f", first + i, sample.frame_ms);
+      for (auto phase_ms : sample.phase_ms)
+        fprintf (file, ",%.3f", phase_ms);
+      fprintf (file, ",%u,%u\n", static_cast<unsigned int> (sample.steps),
+               static_cast<unsigned int> (sample.allocations));
+    }
+  return fclose (file) == 0;
+}
@@ -0,0 +1,80 @@
+/**@file frame_timer.hpp
+ * @brief contains function prototypes for frame timing
+ *
+ * The frame timer measures how long every phase of the main loop takes and
+ * keeps the last frames in a fixed size ring buffer, so that hitches can be
+ * looked at on screen or exported after the fact without a profiler.
+ */
+
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**@brief phases of a frame, in the order they run
+ */
+enum class frame_phase
+{
+  input,
+  update,
+  draw,
+  present,
+  count,
+};
+
+/**@brief timings of a single frame
+ */
+struct frame_sample
+{
+  float phase_ms[static_cast<int> (frame_phase::count)];
+  float frame_ms; // from the start of this frame to the start of the next
+  uint32_t steps; // simulation steps run during the frame
+  uint32_t allocations; // heap allocations made during the frame
+};
+
+/**@brief statistics over the frames in the ring buffer
+ */
+struct frame_summary
+{
+  unsigned int frame_num;
+  float fps;
+  float p50_ms;
+  float p99_ms;
+  float max_ms;
+  float phase_ms[static_cast<int> (frame_phase::count)]; // averages
+  uint32_t max_allocations; // most heap allocations made by a frame
+};
+
+class frame_timer
+{
+public:
+  static constexpr auto capacity = 512u;
+
+  frame_timer ();
+
+  auto begin_frame () -> void;
+  auto end_phase (frame_phase phase) -> void;
+  auto set_steps (uint32_t steps) -> void;
+  auto set_allocations (uint32_t allocations) -> void;
+
+  auto summarize () const -> frame_summary;
+  auto write_csv (const char *path) const -> bool;
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  auto sample_at (unsigned int index) const -> const frame_sample &;
+
+  std::array<frame_sample, capacity> m_samples;
+  unsigned long m_frame_num; // frames completed since the start
+  frame_sample m_current;
+  clock::time_point m_frame_start;
+  clock::time_point m_phase_start;
+  bool m_in_frame;
+
+  mutable std::array<float, capacity> m_sort_scratch;
+};
+
+#endif /* FRAME_TIMER_H */
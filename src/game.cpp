@@ -4,148 +4,26 @@
  */
 
 #include "game.hpp"
-#include "renderer.hpp"
-#include <random>
+#include "trace.hpp"
 #include <algorithm>
 
-static constexpr auto board_width = 10u;
-static constexpr auto board_height = 20u;
 static constexpr auto initial_frames_fall_step = 45u;
+static constexpr auto instant_gravity = 0; // frames per fall step of 20G
 
-// rotation data (uses SRS)
-static const tetromino tetromino_data[static_cast<int> (tetromino_type::count)]
-    = {
-        // I
-        {
-            {
-                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } },
-                { { 2, 0 }, { 2, 1 }, { 2, 2 }, { 2, 3 } },
-                { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 } },
-                { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 1, 3 } },
-            },
-            0xd0edff, // Light blue
-        },
-        // J
-        {
-            {
-                { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 1, 2 } },
-                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 2, 2 } },
-                { { 1, 0 }, { 1, 1 }, { 0, 2 }, { 1, 2 } },
-            },
-            0xfffed9, // Light yellow
-        },
-        // L
-        {
-            {
-                { { 2, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 2, 2 } },
-                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 0, 2 } },
-                { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 2 } },
-            },
-            0xa9a9a9ff, // Dark gray
-        },
-        // O
-        {
-            {
-                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
-            },
-            0xdcdcdcff, // Light gray
-        },
-        // S
-        {
-            {
-                { { 1, 0 }, { 2, 0 }, { 0, 1 }, { 1, 1 } },
-                { { 1, 0 }, { 1, 1 }, { 2, 1 }, { 2, 2 } },
-                { { 1, 1 }, { 2, 1 }, { 0, 2 }, { 1, 2 } },
-                { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } },
-            },
-            0x98fb98ff, // Pale green
-        },
-        // T
-        {
-            {
-                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
-                { { 1, 0 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
-                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
-                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } },
-            },
-            0xe1cff8, // Plum
-        },
-        // Z
-        {
-            {
-                { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 1 } },
-                { { 2, 0 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
-                { { 0, 1 }, { 1, 1 }, { 1, 2 }, { 2, 2 } },
-                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 0, 2 } },
-            },
-            0xffb6c1ff, // Light pink
-        }
-    };
-
-
-
-
-// helpers
-
-/**@brief check for colisions on the board
- *
- * check if the given isntanc of tetormino would collide with the board or not.
- *
- * @param Tetromino instance whose colisions need to be checked.
- * @param Instanc of board against which the collisions need to be checked.
- * @return true if the given tetromino would collide with the board, false
- * otherwise.
- */
-static auto
-is_overlap (const tetromino_instance &p_instance, const board &p_board)
-{
-  const auto tet
-      = tetromino_data[static_cast<int> (p_instance.m_tetromino_type)];
-  const auto block_coords = tet.block_coords[p_instance.m_rotation];
-
-  for (auto i = 0u; i < tetromino::block_num; ++i)
-    {
-      const int x = p_instance.m_pos.x + block_coords[i].x;
-      const int y = p_instance.m_pos.y + block_coords[i].y;
-
-      // overlaping with p_board borders
-      if (x < 0 || x >= static_cast<int> (p_board.width) || y < 0
-          || y >= static_cast<int> (p_board.height))
-        return true;
-
-      if (p_board.static_blocks[x + y * p_board.width] != -1)
-        return true;
-    }
-  return false;
-}
-
-/**@brief Set the block on the board
+/**@brief Constructor of game class
  *
- * Change the value of static blocks on the board.
- * @param instace of board on whose static blocks need to changed.
- * @param coordinates on board which needs to be set/unset.
- * @param value with which the staic block need to be filled.
- * @return void
- */
-static auto
-set_block (board &p_board, const coords i, const unsigned int val)
-{
-  // FIXME: assert that "i" should always be windin bounds
-  p_board.static_blocks[i.x * p_board.width + i.y] = val;
-}
-
-/**@brief Default Constructor of game class
+ * @param seed from which the seed of every game played is derived, the same
+ * seed and inputs always give the same games.
  */
-game::game ()
-    : m_frames_until_fall (initial_frames_fall_step),
-      m_game_state (game::state::title_screen), m_score (0),
-      m_lines_cleared (0)
+game::game (uint64_t seed)
+    : m_seed (seed), m_game_seed (0), m_bag (), m_bag_head (0), m_bag_size (0),
+      m_frames_until_fall (initial_frames_fall_step),
+      m_frames_per_fall_step (initial_frames_fall_step), m_active_tetromino (),
+      m_previous_active_tetromino (), m_game_state (game_state::title_screen),
+      m_score (0), m_lines_cleared (0), m_ghost_tetromino (), m_ghost_source_y (-1),
+      m_ghost_board_revision (0)
 {
+  clear_board (m_board);
 }
 
 /**@brief Initialise the game
@@ -164,19 +42,9 @@ game::init_game () const -> bool
 auto
 game::start_playing () -> void
 {
-  m_board.width = board_width;
-  m_board.height = board_height;
   m_score = 0;
   m_lines_cleared = 0;
-  m_board.static_blocks = std::vector<int> (m_board.width * m_board.height);
-
-  for (auto i = 0u; i < m_board.height; ++i)
-    {
-      for (auto j = 0u; j < m_board.width; ++j)
-        {
-          m_board.static_blocks[i * m_board.width + j] = -1;
-        }
-    }
+  clear_board (m_board);
 
   // ------- INIT --------------------------------------------------------------------------  
   // std::random_device rd;
@@ -186,11 +54,14 @@ game::start_playing () -> void
   // ^^ FORMER METHOD: random draws of ints in range [0,6] for every iter
   
   // CURRENT METHOD: 7-bag randomizer; fills bag with 7 different tetromino pieces in ANY order,
-  // picks from bag until half empty (when bag.size() < 4), and then fills with 7+ pieces
-  bag = {0,1,2,3,4,5,6}; //   fill bag of tetrominos with 7 pieces
-  std::random_device rd_bag;
-  std::mt19937 gen_bag (rd_bag ());
-  std::shuffle(bag.begin(), bag.end(), gen_bag);
+  // picks from bag until half empty (fewer than 4 left), and then fills with 7+ pieces
+  // every game gets its own seed, derived from the seed of the previous one
+  m_game_seed = splitmix64 (m_seed);
+  m_rng.reseed (m_game_seed);
+
+  m_bag_head = 0;
+  m_bag_size = 0;
+  refill_bag ();
 
   // ----- END INIT --------------------------------------------------------------------------
 
@@ -210,9 +81,10 @@ game::start_playing () -> void
 auto
 game::update_playing (const game_input &input) -> void
 {
+  TRACE_ZONE ("game::update_playing");
   if (input.m_pause)
     {
-      m_game_state = state::paused;
+      m_game_state = game_state::paused;
     }
   // horizontal movement
   if (input.m_move_left)
@@ -230,71 +102,32 @@ game::update_playing (const game_input &input) -> void
         m_active_tetromino.m_pos.x = temp_instance.m_pos.x;
     }
 
-  /* rotation floowing tetris SRS (// FIXME: check for special case of *I*
-   * block where SRS can kick 2 blocks instea of one)*/
+  // rotation following tetris SRS, see rotate_tetromino ()
   if (input.m_rotate_clockwise)
-    {
-      auto temp_instance = m_active_tetromino;
-      temp_instance.m_rotation
-          = (temp_instance.m_rotation + tetromino::rotation_num - 1)
-            % tetromino::rotation_num;
-      if (is_overlap (temp_instance, m_board))
-        {
-          temp_instance.m_pos.x = m_active_tetromino.m_pos.x - 1;
-          if (!is_overlap (temp_instance, m_board))
-            m_active_tetromino = temp_instance;
-          else
-            {
-              temp_instance.m_pos.x = m_active_tetromino.m_pos.x + 1;
-              if (!is_overlap (temp_instance, m_board))
-                m_active_tetromino = temp_instance;
-            }
-        }
-      else
-        {
-          m_active_tetromino = temp_instance;
-        }
-    }
-
+    rotate_tetromino (m_active_tetromino, m_board, true);
   if (input.m_rotate_anticlockwise)
-    {
-      auto temp_instance = m_active_tetromino;
-      temp_instance.m_rotation
-          = (temp_instance.m_rotation + 1) % tetromino::rotation_num;
-      if (is_overlap (temp_instance, m_board))
-        {
-          temp_instance.m_pos.x = m_active_tetromino.m_pos.x - 1;
-          if (!is_overlap (temp_instance, m_board))
-            m_active_tetromino = temp_instance;
-          else
-            {
-              temp_instance.m_pos.x = m_active_tetromino.m_pos.x + 1;
-              if (!is_overlap (temp_instance, m_board))
-                m_active_tetromino = temp_instance;
-            }
-        }
-      else
-        {
-          m_active_tetromino = temp_instance;
-        }
-    }
+    rotate_tetromino (m_active_tetromino, m_board, false);
 
   // fall
   --m_frames_until_fall;
   if (m_frames_until_fall <= 0)
     {
       m_frames_until_fall = m_frames_per_fall_step;
-      auto temp_instance = m_active_tetromino;
-      ++temp_instance.m_pos.y;
-      if (is_overlap (temp_instance, m_board))
+      const auto distance = drop_distance (m_active_tetromino, m_board);
+      if (distance == 0)
         {
           summon_tetromino_to_board (m_board, m_active_tetromino);
           if (!generate_tetromino ())
-            m_game_state = state::game_over;
+            m_game_state = game_state::game_over;
+        }
+      else if (m_frames_per_fall_step == instant_gravity)
+        {
+          // 20G, the tetromino lands right away and locks on the next step
+          m_active_tetromino.m_pos.y += distance;
         }
       else
         {
-          m_active_tetromino.m_pos.y = temp_instance.m_pos.y;
+          ++m_active_tetromino.m_pos.y;
         }
     }
 
@@ -310,15 +143,7 @@ game::update_playing (const game_input &input) -> void
 
   if (input.m_hard_drop)
     {
-      auto temp_instance = m_active_tetromino;
-      while (!is_overlap (temp_instance, m_board))
-        {
-          ++temp_instance.m_pos.y;
-        }
-      --temp_instance.m_pos.y;
-      summon_tetromino_to_board (m_board, temp_instance);
-      if (!generate_tetromino ())
-        m_game_state = state::game_over;
+      place_tetromino (get_ghost_tetromino ());
     }
 
   if (input.m_reset)
@@ -328,181 +153,10 @@ game::update_playing (const game_input &input) -> void
 }
 
 
-/**@brief Draw the small windows for the current and next tetrominos (in queue)
- *
- * Draws a smaller icon of the tetromino to be displayed outside the falling board 
- * this is a function to be used inside the game::draw_playing function 
- *
- * @param renderer object which is used to render stuff
- * @param tetromino_index index of tetromino
- * @param x0 starting x coordinate in screen from where to draw small tetromino window
- * @param y0 starting y coordinate in screen from where to draw small tetromino window
-
- * @return void
- */
-auto
-game::draw_smalltetromino (renderer &p_renderer, int tetromino_index, int x0, int y0 ) -> void
-{
-  static auto block_size_in_pixels = 32;
-  auto board_offset_in_pixels = coords (0, 0);
-  
-  // active tetromino
-  for (auto i = 0u; i < 4; ++i)
-    {
-
-      const auto &tet = tetromino_data[tetromino_index];
-      const auto &block_coords
-          = tet.block_coords[m_active_tetromino.m_rotation];
-
-
-      auto tetromino_color_rgba = tet.color;
-
-      const auto mini_scale = 0.7;  // small preview block scale
-
-      const auto x = board_offset_in_pixels.x
-                    //  + (m_active_tetromino.m_pos.x + block_coords[i].x)
-                     + ( block_coords[i].x)
-                           * block_size_in_pixels*mini_scale;
-      const auto y = board_offset_in_pixels.y
-                    //  + (m_active_tetromino.m_pos.y + block_coords[i].y)
-                    + ( block_coords[i].y)
-                           * block_size_in_pixels*mini_scale;
-
-      p_renderer.draw_filled_rectangle (coords (x0+x, y0+y), block_size_in_pixels*mini_scale,
-                                        block_size_in_pixels*mini_scale,
-                                        tetromino_color_rgba);
-    }
-}
-/**@brief Draw the playing field
- *
- * Draw the latest state of the board and falling tetromino using the provided
- * renderer, the function only tells "What to render" on the screen, "how to
- * render that" is handeled by renderer class.
- *
- * @param renderer object which is used to render stuff
- * @return void
- */
-auto
-game::draw_playing (renderer &p_renderer) -> void
-{
-  static auto block_size_in_pixels = 32;
-
-  // draw p_board
-  auto board_width_in_pixels = m_board.width * block_size_in_pixels;
-  auto board_height_in_pixels = m_board.height * block_size_in_pixels;
-
-  auto board_offset_in_pixels = coords (0, 0);
-  if (p_renderer.get_width () > board_width_in_pixels)
-    {
-      board_offset_in_pixels.x
-          = (p_renderer.get_width () - board_width_in_pixels) / 2;
-    }
-  if (p_renderer.get_height () > board_height_in_pixels)
-    {
-      board_offset_in_pixels.y
-          = (p_renderer.get_height () - board_height_in_pixels) / 2;
-    }
-  for (auto i = 0u; i < m_board.height; ++i)
-    {
-      const auto y = board_offset_in_pixels.y + i * block_size_in_pixels;
-      for (auto j = 0u; j < m_board.width; ++j)
-        {
-          const auto x = board_offset_in_pixels.x + j * block_size_in_pixels;
-          const auto block_state
-              = m_board.static_blocks[i * m_board.width + j];
-          auto block_rgba_color = 0x333333ff;
-          if (block_state != -1)
-            {
-              block_rgba_color = tetromino_data[block_state].color;
-            }
-          p_renderer.draw_filled_rectangle (
-              coords (x, y), block_size_in_pixels, block_size_in_pixels,
-              block_rgba_color);
-          p_renderer.draw_rectangle (coords (x, y), block_size_in_pixels,
-                                     block_size_in_pixels, 0x404040ff);
-        }
-    }
-
-  // active tetromino
-  for (auto i = 0u; i < 4; ++i)
-    {
-      const auto &tet = tetromino_data[static_cast<int> (
-          m_active_tetromino.m_tetromino_type)];
-      const auto &block_coords
-          = tet.block_coords[m_active_tetromino.m_rotation];
-      auto tetromino_color_rgba = tet.color;
-
-      const auto x = board_offset_in_pixels.x
-                     + (m_active_tetromino.m_pos.x + block_coords[i].x)
-                           * block_size_in_pixels;
-      const auto y = board_offset_in_pixels.y
-                     + (m_active_tetromino.m_pos.y + block_coords[i].y)
-                           * block_size_in_pixels;
-
-      p_renderer.draw_filled_rectangle (coords (x, y), block_size_in_pixels,
-                                        block_size_in_pixels,
-                                        tetromino_color_rgba);
-    }
-
-  // ghost block (represents location of current block if it were to be hard
-  // dropped)
-  for (auto i = 0u; i < 4; ++i)
-    {
-      auto ghost_block = m_active_tetromino;
-      while (!is_overlap (ghost_block, m_board))
-        {
-          ++ghost_block.m_pos.y;
-        }
-      --ghost_block.m_pos.y;
-
-      const auto &tet
-          = tetromino_data[static_cast<int> (ghost_block.m_tetromino_type)];
-      const auto &block_coords = tet.block_coords[ghost_block.m_rotation];
-      auto tetromino_color_rgba = tet.color;
-
-      const auto x
-          = board_offset_in_pixels.x
-            + (ghost_block.m_pos.x + block_coords[i].x) * block_size_in_pixels;
-      const auto y
-          = board_offset_in_pixels.y
-            + (ghost_block.m_pos.y + block_coords[i].y) * block_size_in_pixels;
-
-      p_renderer.draw_rectangle (coords (x, y), block_size_in_pixels,
-                                 block_size_in_pixels, tetromino_color_rgba);
-    }
-
-  // calculate and print score
-  m_score = 100 * m_lines_cleared;
-  p_renderer.draw_text ("Score :", { 100, 100 }, 0xffffffff);
-  p_renderer.draw_text (std::to_string (m_score), { 100, 130 }, 0xffffffff);
-
-  // Next 3 blocks. These are determined from the contents of the tetrominos `bag` variable
-  p_renderer.draw_text ("Next Blocks:", { 100, 170 }, 0xffffffff);
-
-  int next_tetro = bag.back(), next_tetro2 = bag[bag.size()-2], next_tetro3 = bag[bag.size()-3];
-
-  p_renderer.draw_text (std::to_string (static_cast<int> (next_tetro)), { 100, 200 }, 0xffffffff);
-  draw_smalltetromino (p_renderer, static_cast<int> (next_tetro), 130, 210) ;
-
-  p_renderer.draw_text (std::to_string (static_cast<int> ( next_tetro2 )), { 100, 350 }, 0xffffffff);
-  draw_smalltetromino (p_renderer, static_cast<int> (next_tetro2 ), 130, 360) ;
-
-  p_renderer.draw_text (std::to_string (static_cast<int> ( next_tetro3 )), { 100, 500 }, 0xffffffff);
-  draw_smalltetromino (p_renderer, static_cast<int> (next_tetro3 ), 130, 510) ;
-
-
-}
-
 auto
 game::reset () -> void
 {
-  for(size_t i = 0; i < m_board.height; i++)
-  {
-    for(size_t j = 0; j < m_board.width; j++)
-    {
-      m_board.static_blocks[i * m_board.width + j] = -1;
-    }
-  }
+  clear_board (m_board);
 
   m_lines_cleared = 0;
   m_score = 0;
@@ -514,141 +168,72 @@ game::shutdown () -> void
 {
 }
 
-/**@brief Update the overall state of the game.
+/**@brief Advance the game by one simulation step.
  *
  * The function updates the info of the game object depending on the current
- * state of the game.
+ * state of the game. The game only changes through this function, it doesn't
+ * depend on time or anything else than the inputs it is given.
  *
  * @param input given to the game.
- * @param time since the last udate.
  * @return void
  */
 auto
-game::update (const game_input &input, float delta_time_seconds) -> void
+game::step (const game_input &input) -> void
 {
-  m_delta_time_seconds = delta_time_seconds;
+  m_previous_active_tetromino = m_active_tetromino;
   switch (m_game_state)
     {
-    case state::title_screen:
+    case game_state::title_screen:
       {
         if (input.m_start)
           {
             start_playing ();
-            m_game_state = state::playing;
+            m_game_state = game_state::playing;
           }
       }
       break;
-    case state::playing:
+    case game_state::playing:
       {
         update_playing (input);
       }
       break;
-    case state::paused:
+    case game_state::paused:
       {
         if (input.m_pause)
           {
-            m_game_state = state::playing;
+            m_game_state = game_state::playing;
           }
       }
       break;
-    case state::game_over:
+    case game_state::game_over:
       {
         if (input.m_start)
           {
-            m_game_state = state::title_screen;
+            m_game_state = game_state::title_screen;
           }
       }
       break;
     }
 }
 
-/**@brief draw the current screen depending on the game status
+/**@brief Lock the active tetromino at the given position and bring the next
+ * one
  *
- * As "title screen" and "game over" screens are simply text on screen,their
- * drawing logic is not implemented seperately as a different procedure.
- * @param renderer used to render stuff on screen.
- * @return void
+ * Used by hard drops, and by bots that pick a placement (see movegen.hpp)
+ * instead of sending inputs. The game is over if the next tetromino doesn't
+ * fit.
+ *
+ * @param landing position of the active tetromino, it must be reachable and
+ * unable to move down.
+ * @return the cleared rows and the resulting change of difficulty.
  */
 auto
-game::draw (renderer &p_renderer) -> void
+game::place_tetromino (const tetromino_instance &p_landing) -> lock_result
 {
-  switch (m_game_state)
-    {
-    case state::title_screen:
-      {
-          coords center (p_renderer.get_width ()/2, p_renderer.get_height ()/2);
-
-          p_renderer.draw_text("CONTROLS:",
-                               coords(center.x - 150,
-                                      center.y - 130),
-                               0xffffffff);
-
-          p_renderer.draw_text("LEFT/RIGHT ARROW -- Move Left/Right",
-                               coords(center.x - 100,
-                                      center.y - 100),
-                               0xffffffff);
-
-          p_renderer.draw_text("Z or UP ARROW -- Rotate Clockwise",
-                               coords(center.x - 100,
-                                      center.y - 80),
-                               0xffffffff);
-
-          p_renderer.draw_text("X or LEFT-CTRL -- Rotate Counterclockwise ",
-                               coords(center.x - 100,
-                                      center.y - 60),
-                               0xffffffff);
-
-          p_renderer.draw_text("SPACE -- Hard Drop",
-                               coords(center.x - 100,
-                                      center.y - 40),
-                               0xffffffff);
-
-          p_renderer.draw_text("DOWN ARROW -- Soft Drop",
-                               coords(center.x - 100,
-                                      center.y - 20),
-                               0xffffffff);
-
-          p_renderer.draw_text("P -- Pause Game",
-                               coords(center.x - 100,
-                                      center.y),
-                               0xffffffff);
-
-          p_renderer.draw_text("R -- Reset Game",
-                               coords(center.x - 100,
-                                      center.y + 20),
-                               0xffffffff);
-
-          p_renderer.draw_text("Press enter to start",
-                               coords(center.x - 100,
-                                      center.y + 60),
-                               0xffffffff);
-      }
-      break;
-    case state::playing:
-      {
-        draw_playing (p_renderer);
-      }
-      break;
-    case state::paused:
-      {
-        draw_playing (p_renderer);
-        p_renderer.draw_text ("Paused ",
-                              coords (p_renderer.get_width () / 2 - 40,
-                                      p_renderer.get_height () / 2),
-                              0xffffffff);
-      }
-      break;
-    case state::game_over:
-      {
-        draw_playing (p_renderer);
-        p_renderer.draw_text ("GAME OVER !!",
-                              coords (p_renderer.get_width () / 2 - 100,
-                                      p_renderer.get_height () / 2),
-                              0xffffffff);
-      }
-      break;
-    }
-  // TODO: write fps info on screen
+  const auto result = summon_tetromino_to_board (m_board, p_landing);
+  if (!generate_tetromino ())
+    m_game_state = game_state::game_over;
+  return result;
 }
 
 /**@brief Genrate a tetromino instance with random type and configuration.
@@ -660,9 +245,11 @@ game::draw (renderer &p_renderer) -> void
 auto
 game::generate_tetromino () -> bool
 {
+  TRACE_ZONE ("game::generate_tetromino");
   // pick tetromino [index] from bag
-  int tetro_chosen = bag.back(); // pick from bag
-  bag.pop_back(); // remove from bag
+  int tetro_chosen = get_bag_piece (0); // pick from bag
+  m_bag_head = (m_bag_head + 1) % bag_capacity; // remove from bag
+  --m_bag_size;
 
   m_active_tetromino.m_tetromino_type  = static_cast<tetromino_type> (tetro_chosen) ;
 
@@ -671,17 +258,8 @@ game::generate_tetromino () -> bool
   m_active_tetromino.m_pos.y = 0;
 
   // CONSTRAINT TO KEEP BAG FILLED AND BE ABLE TO PREDICT NEXT 3 TETROMINOS ------------
-  if ( bag.size() < 4 ){
-    // re-fill bag of tetrominos with 7+ shuffled pieces [ if bag has less than 4 tetrominos remaining]
-    std::vector<int> pieces = {0,1,2,3,4,5,6};
-    std::random_device rd_bag;
-    std::mt19937 gen_bag (rd_bag ());
-    std::shuffle(pieces.begin(), pieces.end(), gen_bag);
-
-    // insert pieces to front of array because tetrominos are drawn from back
-    pieces.insert( pieces.end(), bag.begin(), bag.end() );
-    bag = pieces;   
-  }
+  if (m_bag_size < 4)
+    refill_bag ();
 
 
   // -------------------------------------------
@@ -693,61 +271,158 @@ game::generate_tetromino () -> bool
   return true;
 }
 
+/**@brief Add a shuffled set of the 7 tetrominos after the upcoming ones
+ *
+ * The shuffled set is drawn from its end, as the bag used to be a vector
+ * popped from the back, so that seeds keep giving the same games.
+ */
+auto
+game::refill_bag () -> void
+{
+  int pieces[] = { 0, 1, 2, 3, 4, 5, 6 };
+  m_rng.shuffle (pieces, pieces + 7);
+  for (auto i = 7; i-- > 0;)
+    m_bag[(m_bag_head + m_bag_size++) % bag_capacity] = pieces[i];
+}
+
+/**@brief Get a read-only view of the game
+ *
+ * The view stays valid until the next call to step ().
+ * @return current state of the game as seen by a frontend.
+ */
+auto
+game::view () const -> game_view
+{
+  game_view view = {};
+  view.m_state = m_game_state;
+  view.m_game_seed = m_game_seed;
+  view.m_board = &m_board;
+  view.m_score = m_score;
+  view.m_lines_cleared = m_lines_cleared;
+  if (m_game_state != game_state::title_screen)
+    {
+      view.m_active_tetromino = m_active_tetromino;
+      view.m_previous_active_tetromino = m_previous_active_tetromino;
+      view.m_ghost_tetromino = get_ghost_tetromino ();
+      for (auto i = 0u; i < game_view::preview_num; ++i)
+        {
+          view.m_next_tetrominos[i]
+              = static_cast<tetromino_type> (get_bag_piece (i));
+        }
+    }
+  return view;
+}
+
+/**@brief Copy the view of the game into a snapshot
+ *
+ * The board is only copied when it changed since the snapshot was last
+ * filled, its storage is reused so that this doesn't allocate.
+ * @param snapshot to be filled
+ * @return void
+ */
+auto
+game::take_snapshot (game_snapshot &p_snapshot) const -> void
+{
+  if (p_snapshot.m_board.revision != m_board.revision)
+    p_snapshot.m_board = m_board;
+  p_snapshot.m_view = view ();
+  p_snapshot.m_view.m_board = &p_snapshot.m_board;
+}
+
+/**@brief Hash everything that decides how the game goes on
+ *
+ * Combines the board hash with the active tetromino, the bag, the rng and
+ * the counters. Two games with the same hash play on identically for the
+ * same inputs (with overwhelming probability), so simulations running apart
+ * (native and wasm, recorder and player) compare hashes to find divergence.
+ * The ghost tetromino and the previous position are derived and left out.
+ *
+ * @return 64 bit hash of the game state
+ */
+auto
+game::state_hash () const -> uint64_t
+{
+  auto hash = m_board.hash;
+  auto combine = [&hash] (uint64_t value) {
+    hash = fmix64 (hash ^ value) + 0x9e3779b97f4a7c15ull;
+  };
+  combine (static_cast<uint64_t> (m_game_state));
+  combine (m_game_seed);
+  combine (m_seed);
+  combine (m_rng.get_state ());
+  combine (static_cast<uint64_t> (m_active_tetromino.m_tetromino_type)
+           | static_cast<uint64_t> (m_active_tetromino.m_rotation) << 8
+           | static_cast<uint64_t> (m_active_tetromino.m_pos.x & 0xffff) << 16
+           | static_cast<uint64_t> (m_active_tetromino.m_pos.y & 0xffff)
+                 << 32);
+  combine (static_cast<uint32_t> (m_frames_until_fall)
+           | static_cast<uint64_t> (m_frames_per_fall_step) << 32);
+  combine (static_cast<uint64_t> (m_score));
+  combine (static_cast<uint64_t> (m_lines_cleared));
+  combine (m_bag_size);
+  for (auto i = m_bag_size; i-- > 0;)
+    combine (static_cast<uint64_t> (get_bag_piece (i)));
+  return hash;
+}
+
+/**@brief Get the landing position of the active tetromino
+ *
+ * The result is memoized until the active tetromino or the board changes.
+ * @return the active tetromino moved down as far as it can go.
+ */
+auto
+game::get_ghost_tetromino () const -> const tetromino_instance &
+{
+  const auto &active = m_active_tetromino;
+  auto &ghost = m_ghost_tetromino;
+  if (m_ghost_board_revision != m_board.revision
+      || ghost.m_tetromino_type != active.m_tetromino_type
+      || ghost.m_rotation != active.m_rotation
+      || ghost.m_pos.x != active.m_pos.x || m_ghost_source_y != active.m_pos.y)
+    {
+      ghost = active;
+      ghost.m_pos.y += drop_distance (active, m_board);
+      m_ghost_source_y = active.m_pos.y;
+      m_ghost_board_revision = m_board.revision;
+    }
+  return ghost;
+}
+
 /**@brief Bring the given tetromino instance on board.
  *
  * bring the tetromino to the board. The function also clears lines if the
- * tetromino completes a row.
+ * tetromino completes a row, only the rows covered by the tetromino are
+ * checked.
  *
  * @param instance of the board on which the tetromino needss to be brought.
  * @param instance of the tetromino which needs to be brought on the boartd.
- * @return void
+ * @return the cleared rows and the resulting change of difficulty.
  */
 auto
 game::summon_tetromino_to_board (
-    board &p_board, const tetromino_instance &p_tetromino_instance) -> void
+    board &p_board, const tetromino_instance &p_tetromino_instance)
+    -> lock_result
 {
-  const auto &tet = tetromino_data[static_cast<int> (
-      p_tetromino_instance.m_tetromino_type)];
-  const auto &block_coords = tet.block_coords[p_tetromino_instance.m_rotation];
-  for (auto i = 0u; i < tetromino::block_num; ++i)
-    {
-      const int x = p_tetromino_instance.m_pos.x + block_coords[i].x;
-      const int y = p_tetromino_instance.m_pos.y + block_coords[i].y;
-
-      // TODO: assert that tetromino doesn't go out of board
-
-      p_board.static_blocks[x + y * p_board.width]
-          = static_cast<unsigned int> (p_tetromino_instance.m_tetromino_type);
-    }
+  TRACE_ZONE ("game::summon_tetromino_to_board");
+  lock_tetromino (p_board, p_tetromino_instance);
 
   // clear rows
-  for (auto y = 0u; y < p_board.height; ++y)
+  lock_result result = {};
+  result.lines = clear_full_rows (p_board, p_tetromino_instance.m_pos.y,
+                                  tetromino::block_num);
+
+  const auto previous_frames_per_fall_step = m_frames_per_fall_step;
+  for (auto i = 0u; i < result.lines.count; ++i)
     {
-      bool current_row_filled = true;
-      for (auto x = 0u; x < p_board.width; ++x)
-        {
-          if (p_board.static_blocks[x + y * p_board.width] == -1)
-            {
-              current_row_filled = false;
-              break;
-            }
-        }
-      if (current_row_filled)
-        {
-          ++m_lines_cleared;
-          // increase diffculty for every 5 line clears
-          constexpr int difficulty_step = 5;
-
-          if (m_lines_cleared && (m_lines_cleared % difficulty_step) == 0)
-            m_frames_per_fall_step = std::max (15, m_frames_per_fall_step - 5);
-          for (auto i = y; i > 0; --i)
-            {
-              for (auto j = 0u; j < p_board.width; ++j)
-                {
-                  p_board.static_blocks[j + i * p_board.width]
-                      = p_board.static_blocks[j + (i - 1) * p_board.width];
-                }
-            }
-        }
+      ++m_lines_cleared;
+      // increase diffculty for every 5 line clears
+      constexpr int difficulty_step = 5;
+
+      if (m_lines_cleared && (m_lines_cleared % difficulty_step) == 0)
+        m_frames_per_fall_step = std::max (15, m_frames_per_fall_step - 5);
     }
+  m_score = 100 * m_lines_cleared;
+  result.frames_per_fall_step_change
+      = m_frames_per_fall_step - previous_frames_per_fall_step;
+  return result;
 }
@@ -1,109 +1,141 @@
 /**@file game.hpp
  * @brief contains function prototypes for game
  *
- * This contains function prototypes responsible for the game logic.
+ * This contains function prototypes responsible for the game logic. The game
+ * logic doesn't depend on SDL, frontends feed it inputs through game::step ()
+ * and draw it from game::view ().
  */
 
 #ifndef GAME_H
 #define GAME_H
 
+#include "board.hpp"
+#include "rng.hpp"
 #include "utils.hpp"
 #include <memory>
 #include <vector>
 
-class renderer;
-
-struct tetromino
+struct game_input
 {
-  static constexpr auto block_num = 4u;
-  static constexpr auto rotation_num = 4u;
-
-  coords block_coords[block_num][rotation_num];
-
-  unsigned int color;
+  bool m_start;
+  bool m_pause;
+  bool m_move_left;
+  bool m_move_right;
+  bool m_rotate_clockwise;
+  bool m_rotate_anticlockwise;
+  bool m_hard_drop;
+  bool m_soft_drop;
+  bool m_reset;
 };
 
-enum class tetromino_type
+/**@brief outcome of locking a tetromino on the board
+ */
+struct lock_result
 {
-  I,
-  J,
-  L,
-  O,
-  S,
-  T,
-  Z,
-  count
+  line_clear_result lines;
+  int frames_per_fall_step_change; // negative when the game speeds up
 };
 
-struct tetromino_instance
+enum class game_state
 {
-  tetromino_type m_tetromino_type;
-  coords m_pos;
-  unsigned int m_rotation;
+  title_screen,
+  playing,
+  paused,
+  game_over,
 };
 
-struct board
+/**@brief read-only view of the game state, used by frontends
+ */
+struct game_view
 {
-  unsigned int width;
-  unsigned int height;
-  std::vector<int> static_blocks;
+  static constexpr auto preview_num = 3u;
+
+  game_state m_state;
+  uint64_t m_game_seed;
+  const board *m_board;
+  tetromino_instance m_active_tetromino;
+  tetromino_instance m_previous_active_tetromino; // before the last step
+  tetromino_instance m_ghost_tetromino;
+  tetromino_type m_next_tetrominos[preview_num];
+  long int m_score;
+  int m_lines_cleared;
 };
 
-struct game_input
+/**@brief copy of a game_view that doesn't depend on the game any more
+ *
+ * Filled by game::take_snapshot () so that another thread can draw the game
+ * while it goes on. m_view.m_board points to the snapshot's own board.
+ */
+struct game_snapshot
 {
-  bool m_start;
-  bool m_pause;
-  bool m_move_left;
-  bool m_move_right;
-  bool m_rotate_clockwise;
-  bool m_rotate_anticlockwise;
-  bool m_hard_drop;
-  bool m_soft_drop;
-  bool m_reset;
+  game_view m_view;
+  board m_board;
 };
 
 class game
 {
 public:
-  game ();
+  // fixed rate at which step () must be called, every duration of the game
+  // (like m_frames_per_fall_step) is counted in steps
+  static constexpr auto steps_per_second = 60;
+
+  explicit game (uint64_t seed = 0);
 
   auto init_game () const -> bool;
 
   auto start_playing () -> void;
   auto update_playing (const game_input &input) -> void;
-  auto draw_smalltetromino (renderer &p_renderer, int which_m_type, int x0, int y0 ) -> void;
-  auto draw_playing (renderer &p_renderer) -> void;
 
   auto reset () -> void;
   auto shutdown () -> void;
-  auto update (const game_input &input, float delta_time_seconds) -> void;
-  auto draw (renderer &p_renderer) -> void;
+  auto step (const game_input &input) -> void;
+  auto place_tetromino (const tetromino_instance &p_landing) -> lock_result;
+  auto view () const -> game_view;
+  auto take_snapshot (game_snapshot &p_snapshot) const -> void;
+  auto state_hash () const -> uint64_t;
 
 private:
-  auto generate_tetromino () -> bool;
-  auto summon_tetromino_to_board (
-      board &p_board, const tetromino_instance &p_tetromino_instance) -> void;
+  friend struct bench_access; // bench.cpp times the private steps one by one
 
-  enum class state
+  auto generate_tetromino () -> bool;
+  auto refill_bag () -> void;
+  auto
+  get_bag_piece (unsigned int i) const
   {
-    title_screen,
-    playing,
-    paused,
-    game_over,
-  };
-
-  std::vector<int> bag; // bag of tetrominos (fill it with 7 pieces until empty, then fill again - 7-bag randomizer) 
+    return m_bag[(m_bag_head + i) % bag_capacity];
+  }
+  auto get_ghost_tetromino () const -> const tetromino_instance &;
+  auto summon_tetromino_to_board (
+      board &p_board, const tetromino_instance &p_tetromino_instance)
+      -> lock_result;
+
+  uint64_t m_seed;      // seed of the next game
+  uint64_t m_game_seed; // seed of the current game
+  rng m_rng;
+  // upcoming tetrominos, next one first (7-bag randomizer: 7 shuffled pieces
+  // are added whenever fewer than 4 are left). A ring of fixed capacity so
+  // that refilling it never allocates.
+  static constexpr auto bag_capacity = 16u;
+  int m_bag[bag_capacity];
+  unsigned int m_bag_head; // index of the next tetromino
+  unsigned int m_bag_size;
   int m_frames_until_fall;
   int m_frames_per_fall_step; // control speed of the game
   tetromino_instance m_active_tetromino;
+  tetromino_instance m_previous_active_tetromino;
   board m_board;
-  state m_game_state;
-  float m_delta_time_seconds;
+  game_state m_game_state;
 
   // used for calculating score
   long int m_score;
   int m_lines_cleared;
 
+  // landing position of the active tetromino, valid while the active
+  // tetromino and board revision match
+  mutable tetromino_instance m_ghost_tetromino;
+  mutable int m_ghost_source_y;
+  mutable unsigned int m_ghost_board_revision;
+
 };
 
 #endif /* GAME_H */
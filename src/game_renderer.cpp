@@ -0,0 +1,390 @@
+/**@file game_renderer.cpp
+ * @brief contains functions that draw the game.
+ *
+ */
+
+#include "game_renderer.hpp"
+#include "renderer.hpp"
+#include <cstdio>
+
+// depths of the recorded commands, commands that overlap are at different
+// depths (see command_buffer.hpp)
+static constexpr unsigned char board_depth = 0; // board layer or cells
+static constexpr unsigned char grid_depth = 1;  // outlines of the cells
+static constexpr unsigned char piece_depth = 2; // active tetromino and HUD
+static constexpr unsigned char ghost_depth = 3;
+static constexpr unsigned char message_depth = game_renderer::top_depth;
+
+/**@brief Default Constructor of game_renderer class
+ */
+game_renderer::game_renderer ()
+    : m_board_layer (-1), m_board_layer_revision (0),
+      m_board_layer_generation (0)
+{
+}
+
+/**@brief Draw the small windows for the current and next tetrominos (in queue)
+ *
+ * Records a smaller icon of the tetromino to be displayed outside the falling
+ * board, this is a function to be used inside the
+ * game_renderer::draw_playing function
+ *
+ * @param command buffer the blocks are recorded into
+ * @param view of the game being drawn
+ * @param tetromino_index index of tetromino
+ * @param x0 starting x coordinate in screen from where to draw small tetromino window
+ * @param y0 starting y coordinate in screen from where to draw small tetromino window
+
+ * @return void
+ */
+auto
+game_renderer::draw_smalltetromino (command_buffer &p_commands, const game_view &p_view, int tetromino_index, int x0, int y0 ) -> void
+{
+  static auto block_size_in_pixels = 32;
+  auto board_offset_in_pixels = coords (0, 0);
+  
+  // active tetromino
+  for (auto i = 0u; i < 4; ++i)
+    {
+
+      const auto &tet = tetromino_data[tetromino_index];
+      const auto &block_coords
+          = tet.block_coords[p_view.m_active_tetromino.m_rotation];
+
+
+      auto tetromino_color_rgba = tet.color;
+
+      const auto mini_scale = 0.7;  // small preview block scale
+
+      const auto x = board_offset_in_pixels.x
+                    //  + (m_active_tetromino.m_pos.x + block_coords[i].x)
+                     + ( block_coords[i].x)
+                           * block_size_in_pixels*mini_scale;
+      const auto y = board_offset_in_pixels.y
+                    //  + (m_active_tetromino.m_pos.y + block_coords[i].y)
+                    + ( block_coords[i].y)
+                           * block_size_in_pixels*mini_scale;
+
+      p_commands.draw_block (
+          piece_depth,
+          { coords (x0 + x, y0 + y),
+            static_cast<int> (block_size_in_pixels * mini_scale),
+            tetromino_color_rgba, block_sprite::filled });
+    }
+}
+/**@brief Record a cell of the board and its grid outline
+ *
+ * @param command buffer the blocks are recorded into
+ * @param board the cell belongs to
+ * @param column of the cell
+ * @param row of the cell
+ * @param location of the cell on the screen
+ * @return void
+ */
+auto
+game_renderer::push_board_cell (command_buffer &p_commands,
+                                const board &p_board, unsigned int x,
+                                unsigned int y, const coords loc) -> void
+{
+  static auto block_size_in_pixels = 32;
+
+  const auto block_state = get_block (p_board, x, y);
+  uint32_t block_rgba_color = 0x333333ff;
+  if (block_state != -1)
+    {
+      block_rgba_color = tetromino_data[block_state].color;
+    }
+  p_commands.draw_block (board_depth, { loc, block_size_in_pixels,
+                                        block_rgba_color,
+                                        block_sprite::filled });
+  p_commands.draw_block (grid_depth, { loc, block_size_in_pixels, 0x404040ff,
+                                       block_sprite::outline });
+}
+
+/**@brief Record the static blocks and grid of the board
+ *
+ * @param command buffer the blocks are recorded into
+ * @param board to be drawn
+ * @param location of the top left corner of the board
+ * @return void
+ */
+auto
+game_renderer::draw_board (command_buffer &p_commands, const board &p_board,
+                           const coords offset) -> void
+{
+  static auto block_size_in_pixels = 32;
+
+  for (auto i = 0u; i < p_board.height; ++i)
+    {
+      const auto y = offset.y + i * block_size_in_pixels;
+      for (auto j = 0u; j < p_board.width; ++j)
+        {
+          const auto x = offset.x + j * block_size_in_pixels;
+          push_board_cell (p_commands, p_board, j, i, coords (x, y));
+        }
+    }
+}
+
+/**@brief Draw the playing field
+ *
+ * Record the latest state of the board and falling tetromino, the function
+ * only tells "What to render" on the screen, "how to render that" is
+ * handeled by renderer class when the commands are submitted.
+ *
+ * The falling tetromino is drawn between its positions before and after the
+ * last step, so that it falls smoothly whatever the refresh rate is.
+ *
+ * @param renderer the board layer is drawn with
+ * @param command buffer the frame is recorded into
+ * @param view of the game being drawn
+ * @param fraction of the next step already elapsed, in [0, 1)
+ * @return void
+ */
+auto
+game_renderer::draw_playing (renderer &p_renderer, command_buffer &p_commands,
+                             const game_view &p_view, float interpolation)
+    -> void
+{
+  static auto block_size_in_pixels = 32;
+
+  const auto &m_board = *p_view.m_board;
+  const auto &m_active_tetromino = p_view.m_active_tetromino;
+
+  // draw p_board
+  auto board_width_in_pixels = m_board.width * block_size_in_pixels;
+  auto board_height_in_pixels = m_board.height * block_size_in_pixels;
+
+  auto board_offset_in_pixels = coords (0, 0);
+  if (p_renderer.get_width () > board_width_in_pixels)
+    {
+      board_offset_in_pixels.x
+          = (p_renderer.get_width () - board_width_in_pixels) / 2;
+    }
+  if (p_renderer.get_height () > board_height_in_pixels)
+    {
+      board_offset_in_pixels.y
+          = (p_renderer.get_height () - board_height_in_pixels) / 2;
+    }
+  // static blocks, copied from the board layer when possible
+  if (m_board_layer < 0)
+    {
+      m_board_layer = p_renderer.create_layer (board_width_in_pixels,
+                                               board_height_in_pixels);
+      ++m_board_layer_revision; // force the first redraw
+    }
+  if (m_board_layer >= 0)
+    {
+      if (m_board_layer_revision != m_board.revision
+          || m_board_layer_generation != p_renderer.get_layer_generation ())
+        {
+          if (p_renderer.begin_layer (m_board_layer))
+            {
+              m_board_commands.clear ();
+              draw_board (m_board_commands, m_board, coords (0, 0));
+              m_board_commands.submit (p_renderer);
+              p_renderer.end_layer ();
+              m_board_layer_revision = m_board.revision;
+              m_board_layer_generation = p_renderer.get_layer_generation ();
+              p_commands.mark_changed ();
+            }
+        }
+      p_commands.draw_layer (board_depth, m_board_layer,
+                             board_offset_in_pixels);
+    }
+  else
+    {
+      // no render target support, draw the board along with everything else
+      draw_board (p_commands, m_board, board_offset_in_pixels);
+    }
+
+  // active tetromino, only a plain one row fall is interpolated (moves,
+  // rotations and new tetrominos snap)
+  const auto &previous = p_view.m_previous_active_tetromino;
+  auto fall_offset_in_pixels = 0;
+  if (previous.m_tetromino_type == m_active_tetromino.m_tetromino_type
+      && previous.m_rotation == m_active_tetromino.m_rotation
+      && previous.m_pos.x == m_active_tetromino.m_pos.x
+      && previous.m_pos.y + 1 == m_active_tetromino.m_pos.y)
+    {
+      fall_offset_in_pixels = static_cast<int> (
+          (interpolation - 1.0f) * block_size_in_pixels);
+    }
+  for (auto i = 0u; i < 4; ++i)
+    {
+      const auto &tet = tetromino_data[static_cast<int> (
+          m_active_tetromino.m_tetromino_type)];
+      const auto &block_coords
+          = tet.block_coords[m_active_tetromino.m_rotation];
+      auto tetromino_color_rgba = tet.color;
+
+      const auto x = board_offset_in_pixels.x
+                     + (m_active_tetromino.m_pos.x + block_coords[i].x)
+                           * block_size_in_pixels;
+      const auto y = board_offset_in_pixels.y
+                     + (m_active_tetromino.m_pos.y + block_coords[i].y)
+                           * block_size_in_pixels
+                     + fall_offset_in_pixels;
+
+      p_commands.draw_block (piece_depth,
+                             { coords (x, y), block_size_in_pixels,
+                               tetromino_color_rgba, block_sprite::filled });
+    }
+
+  // ghost block (represents location of current block if it were to be hard
+  // dropped)
+  const auto &ghost_block = p_view.m_ghost_tetromino;
+  const auto &ghost_tet
+      = tetromino_data[static_cast<int> (ghost_block.m_tetromino_type)];
+  const auto &ghost_block_coords
+      = ghost_tet.block_coords[ghost_block.m_rotation];
+  for (auto i = 0u; i < 4; ++i)
+    {
+      const auto x = board_offset_in_pixels.x
+                     + (ghost_block.m_pos.x + ghost_block_coords[i].x)
+                           * block_size_in_pixels;
+      const auto y = board_offset_in_pixels.y
+                     + (ghost_block.m_pos.y + ghost_block_coords[i].y)
+                           * block_size_in_pixels;
+
+      p_commands.draw_block (ghost_depth,
+                             { coords (x, y), block_size_in_pixels,
+                               ghost_tet.color, block_sprite::outline });
+    }
+
+  // print score
+  p_commands.draw_text (piece_depth, "Score :", { 100, 100 }, 0xffffffff);
+  // formatted on the stack, the command buffer copies it into storage it
+  // reuses every frame
+  char text[32];
+  snprintf (text, sizeof (text), "%ld", p_view.m_score);
+  p_commands.draw_text (piece_depth, text, { 100, 130 }, 0xffffffff);
+
+  // Next 3 blocks. These are determined from the contents of the tetrominos `bag` variable
+  p_commands.draw_text (piece_depth, "Next Blocks:", { 100, 170 },
+                        0xffffffff);
+
+  int next_tetro = static_cast<int> (p_view.m_next_tetrominos[0]),
+      next_tetro2 = static_cast<int> (p_view.m_next_tetrominos[1]),
+      next_tetro3 = static_cast<int> (p_view.m_next_tetrominos[2]);
+
+  snprintf (text, sizeof (text), "%d", next_tetro);
+  p_commands.draw_text (piece_depth, text, { 100, 200 }, 0xffffffff);
+  draw_smalltetromino (p_commands, p_view, static_cast<int> (next_tetro), 130, 210) ;
+
+  snprintf (text, sizeof (text), "%d", next_tetro2);
+  p_commands.draw_text (piece_depth, text, { 100, 350 }, 0xffffffff);
+  draw_smalltetromino (p_commands, p_view, static_cast<int> (next_tetro2 ), 130, 360) ;
+
+  snprintf (text, sizeof (text), "%d", next_tetro3);
+  p_commands.draw_text (piece_depth, text, { 100, 500 }, 0xffffffff);
+  draw_smalltetromino (p_commands, p_view, static_cast<int> (next_tetro3 ), 130, 510) ;
+}
+
+/**@brief record the current screen depending on the game status
+ *
+ * As "title screen" and "game over" screens are simply text on screen,their
+ * drawing logic is not implemented seperately as a different procedure.
+ * @param renderer used to render stuff on screen.
+ * @param command buffer the frame is appended to, submitted by the caller
+ * @param view of the game being drawn
+ * @param fraction of the next step already elapsed, in [0, 1)
+ * @return void
+ */
+auto
+game_renderer::draw (renderer &p_renderer, command_buffer &p_commands,
+                     const game_view &p_view, float interpolation) -> void
+{
+  switch (p_view.m_state)
+    {
+    case game_state::title_screen:
+      {
+          coords center (p_renderer.get_width ()/2, p_renderer.get_height ()/2);
+
+          p_commands.draw_text(message_depth, "CONTROLS:",
+                               coords(center.x - 150,
+                                      center.y - 130),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "LEFT/RIGHT ARROW -- Move Left/Right",
+                               coords(center.x - 100,
+                                      center.y - 100),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "Z or UP ARROW -- Rotate Clockwise",
+                               coords(center.x - 100,
+                                      center.y - 80),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "X or LEFT-CTRL -- Rotate Counterclockwise ",
+                               coords(center.x - 100,
+                                      center.y - 60),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "SPACE -- Hard Drop",
+                               coords(center.x - 100,
+                                      center.y - 40),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "DOWN ARROW -- Soft Drop",
+                               coords(center.x - 100,
+                                      center.y - 20),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "P -- Pause Game",
+                               coords(center.x - 100,
+                                      center.y),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "R -- Reset Game",
+                               coords(center.x - 100,
+                                      center.y + 20),
+                               0xffffffff);
+
+          p_commands.draw_text(message_depth, "Press enter to start",
+                               coords(center.x - 100,
+                                      center.y + 60),
+                               0xffffffff);
+      }
+      break;
+    case game_state::playing:
+      {
+        draw_playing (p_renderer, p_commands, p_view, interpolation);
+      }
+      break;
+    case game_state::paused:
+      {
+        draw_playing (p_renderer, p_commands, p_view, 1.0f);
+        p_commands.draw_text (message_depth, "Paused ",
+                              coords (p_renderer.get_width () / 2 - 40,
+                                      p_renderer.get_height () / 2),
+                              0xffffffff);
+      }
+      break;
+    case game_state::game_over:
+      {
+        draw_playing (p_renderer, p_commands, p_view, 1.0f);
+        p_commands.draw_text (message_depth, "GAME OVER !!",
+                              coords (p_renderer.get_width () / 2 - 100,
+                                      p_renderer.get_height () / 2),
+                              0xffffffff);
+      }
+      break;
+    }
+}
+
+/**@brief draw the current screen right away
+ *
+ * Records the screen into a buffer of its own and submits it.
+ * @param renderer used to render stuff on screen.
+ * @param view of the game being drawn
+ * @param fraction of the next step already elapsed, in [0, 1)
+ * @return void
+ */
+auto
+game_renderer::draw (renderer &p_renderer, const game_view &p_view,
+                     float interpolation) -> void
+{
+  m_commands.clear ();
+  draw (p_renderer, m_commands, p_view, interpolation);
+  m_commands.submit (p_renderer);
+}
@@ -0,0 +1,57 @@
+/**@file game_renderer.hpp
+ * @brief contains function prototypes for drawing the game
+ *
+ * This contains the SDL frontend of the game, it records what to draw for a
+ * given view of the game into a command buffer (see command_buffer.hpp).
+ */
+
+#ifndef GAME_RENDERER_H
+#define GAME_RENDERER_H
+
+#include "command_buffer.hpp"
+#include "game.hpp"
+#include "utils.hpp"
+
+class renderer;
+
+class game_renderer
+{
+public:
+  // commands are recorded at depths up to top_depth, draw above it to cover
+  // the game
+  static constexpr unsigned char top_depth = 4;
+
+  game_renderer ();
+
+  auto draw (renderer &p_renderer, command_buffer &p_commands,
+             const game_view &p_view, float interpolation = 0.0f) -> void;
+  auto draw (renderer &p_renderer, const game_view &p_view,
+             float interpolation = 0.0f) -> void;
+
+private:
+  friend struct bench_access; // bench.cpp times draw_playing on its own
+
+  auto draw_smalltetromino (command_buffer &p_commands,
+                            const game_view &p_view, int tetromino_index,
+                            int x0, int y0) -> void;
+  auto draw_playing (renderer &p_renderer, command_buffer &p_commands,
+                     const game_view &p_view, float interpolation) -> void;
+  auto push_board_cell (command_buffer &p_commands, const board &p_board,
+                        unsigned int x, unsigned int y, const coords loc)
+      -> void;
+  auto draw_board (command_buffer &p_commands, const board &p_board,
+                   const coords offset) -> void;
+
+  // frame recorded and submitted by draw () when no buffer is given
+  command_buffer m_commands;
+  // static blocks and grid, submitted to the board layer when it's redrawn
+  command_buffer m_board_commands;
+
+  // static blocks and grid are drawn to a layer of the renderer, which is
+  // only redrawn when the board or the layer's contents change
+  int m_board_layer;
+  unsigned int m_board_layer_revision;
+  unsigned int m_board_layer_generation;
+};
+
+#endif /* GAME_RENDERER_H */
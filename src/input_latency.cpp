@@ -0,0 +1,198 @@
+/**@file input_latency.cpp
+ * @brief contains functions that measure the latency of the inputs.
+ *
+ */
+
+#include "input_latency.hpp"
+#include <algorithm>
+#include <cstdio>
+
+static const char *const input_kind_names[]
+    = { "move", "rotate", "soft_drop", "hard_drop" };
+static_assert (sizeof (input_kind_names) / sizeof (input_kind_names[0])
+                   == static_cast<int> (input_kind::count),
+               "every input kind needs a name");
+
+/**@brief milliseconds between two times
+ */
+static auto
+elapsed_ms (input_latency::clock::time_point from,
+            input_latency::clock::time_point to) -> float
+{
+  return std::chrono::duration<float, std::milli> (to - from).count ();
+}
+
+/**@brief Constructor of input_latency class
+ */
+input_latency::input_latency ()
+    : m_pending (), m_pending_num (0), m_dropped (0), m_histograms ()
+{
+}
+
+/**@brief Start following an input that was just polled
+ *
+ * @param kind of the input
+ * @param event_time the OS stamped the event with
+ * @param poll_time the event was read
+ * @param sequence of the hand over that gives the input to the simulation,
+ * see on_consumed ()
+ * @return void
+ */
+auto
+input_latency::on_event (input_kind kind, clock::time_point event_time,
+                         clock::time_point poll_time, uint32_t sequence)
+    -> void
+{
+  if (m_pending_num == max_pending)
+    {
+      ++m_dropped;
+      return;
+    }
+  m_pending[m_pending_num++]
+      = { kind, sequence, false, event_time, poll_time, {} };
+}
+
+/**@brief Mark the inputs handed over to the simulation up to a sequence as
+ * consumed by a step
+ *
+ * @param sequence of the last hand over the step consumed
+ * @param step_time the step ran
+ * @return void
+ */
+auto
+input_latency::on_consumed (uint32_t sequence, clock::time_point step_time)
+    -> void
+{
+  for (auto i = 0; i < m_pending_num; ++i)
+    {
+      auto &input = m_pending[i];
+      // sequences wrap around, compare their distance
+      if (!input.consumed
+          && static_cast<int32_t> (sequence - input.sequence) >= 0)
+        {
+          input.consumed = true;
+          input.step_time = std::max (step_time, input.poll_time);
+        }
+    }
+}
+
+/**@brief Complete the inputs whose result was just presented (or would have
+ * been, for a frame identical to the one on screen)
+ *
+ * @param present_time the frame was presented
+ * @return void
+ */
+auto
+input_latency::on_presented (clock::time_point present_time) -> void
+{
+  auto kept = 0;
+  for (auto i = 0; i < m_pending_num; ++i)
+    {
+      const auto &input = m_pending[i];
+      if (!input.consumed)
+        {
+          m_pending[kept++] = input;
+          continue;
+        }
+
+      auto &histogram = m_histograms[static_cast<int> (input.kind)];
+      const auto total_ms = elapsed_ms (input.event_time, present_time);
+      const auto bucket = std::min (
+          static_cast<int> (std::max (total_ms, 0.0f)
+                            / latency_histogram::bucket_ms),
+          latency_histogram::bucket_num - 1);
+      ++histogram.buckets[bucket];
+      ++histogram.count;
+      histogram.max_ms = std::max (histogram.max_ms, total_ms);
+      histogram.queued_ms += elapsed_ms (input.event_time, input.poll_time);
+      histogram.waiting_ms += elapsed_ms (input.poll_time, input.step_time);
+      histogram.drawing_ms += elapsed_ms (input.step_time, present_time);
+    }
+  m_pending_num = kept;
+}
+
+/**@brief Latency below which a percentage of the inputs of a kind were
+ *
+ * @param kind of the inputs
+ * @param percent of the inputs
+ * @return upper bound of the bucket of the percentile, 0 if no input of the
+ * kind was measured
+ */
+auto
+input_latency::percentile (input_kind kind, unsigned int percent) const
+    -> float
+{
+  const auto &histogram = m_histograms[static_cast<int> (kind)];
+  if (!histogram.count)
+    return 0;
+
+  // nearest rank
+  const auto rank = std::max ((histogram.count * percent + 99) / 100, 1u);
+  auto seen = 0u;
+  for (auto i = 0; i < latency_histogram::bucket_num; ++i)
+    {
+      seen += histogram.buckets[i];
+      if (seen >= rank)
+        return std::min ((i + 1) * latency_histogram::bucket_ms,
+                         histogram.max_ms);
+    }
+  return histogram.max_ms;
+}
+
+/**@brief Print the percentiles and the average stages of every kind of
+ * input
+ *
+ * @return void
+ */
+auto
+input_latency::print () const -> void
+{
+  printf ("Input to photon latency (ms):\n");
+  printf ("  %-10s %6s %7s %7s %7s %7s   %7s %7s %7s\n", "input", "count",
+          "p50", "p95", "p99", "max", "queued", "waiting", "drawing");
+  for (auto kind = 0; kind < static_cast<int> (input_kind::count); ++kind)
+    {
+      const auto &histogram = m_histograms[kind];
+      if (!histogram.count)
+        continue;
+      printf ("  %-10s %6u %7.1f %7.1f %7.1f %7.1f   %7.2f %7.2f %7.2f\n",
+              input_kind_names[kind],
+              static_cast<unsigned int> (histogram.count),
+              percentile (static_cast<input_kind> (kind), 50),
+              percentile (static_cast<input_kind> (kind), 95),
+              percentile (static_cast<input_kind> (kind), 99),
+              histogram.max_ms, histogram.queued_ms / histogram.count,
+              histogram.waiting_ms / histogram.count,
+              histogram.drawing_ms / histogram.count);
+    }
+  if (m_dropped)
+    printf ("  %u inputs not measured, too many were pending\n",
+            static_cast<unsigned int> (m_dropped));
+}
+
+/**@brief Write the histograms to a CSV file, one row per non empty bucket
+ *
+ * @param path of the file to be written
+ * @return true if the file was written, false otherwise
+ */
+auto
+input_latency::write_csv (const char *path) const -> bool
+{
+  auto *file = fopen (path, "w");
+  if (!file)
+    return false;
+
+  fprintf (file, "input,latency_ms,count\n");
+  for (auto kind = 0; kind < static_cast<int> (input_kind::count); ++kind)
+    {
+      const auto &histogram = m_histograms[kind];
+      for (auto i = 0; i < latency_histogram::bucket_num; ++i)
+        {
+          if (histogram.buckets[i])
+            fprintf (file, "%s,%.1f,%u\n", input_kind_names[kind],
+                     i * latency_histogram::bucket_ms,
+                     static_cast<unsigned int> (histogram.buckets[i]));
+        }
+    }
+  return fclose (file) == 0;
+}
@@ -0,0 +1,83 @@
+/**@file input_latency.hpp
+ * @brief contains function prototypes for input latency measurement
+ *
+ * Follows every key press from the time the OS stamped its event, through
+ * the poll that read it and the simulation step that consumed it, to the
+ * frame that first presented the result, and keeps a histogram of the whole
+ * latency for every kind of input. Everything is stored in fixed size arrays
+ * so that measuring doesn't change the allocation free frames it measures.
+ */
+
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**@brief kinds of input the latency is reported for
+ */
+enum class input_kind
+{
+  move,
+  rotate,
+  soft_drop,
+  hard_drop,
+  count,
+};
+
+/**@brief latencies of one kind of input
+ */
+struct latency_histogram
+{
+  static constexpr auto bucket_ms = 0.5f;
+  static constexpr auto bucket_num = 400; // the last one holds the outliers
+
+  std::array<uint32_t, bucket_num> buckets;
+  uint32_t count;
+  float max_ms;
+  // sums of the stages, for their averages
+  double queued_ms;   // from the OS event to the poll
+  double waiting_ms;  // from the poll to the step consuming the input
+  double drawing_ms;  // from the step to the frame presenting the result
+};
+
+class input_latency
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto max_pending = 64;
+
+  input_latency ();
+
+  auto on_event (input_kind kind, clock::time_point event_time,
+                 clock::time_point poll_time, uint32_t sequence) -> void;
+  auto on_consumed (uint32_t sequence, clock::time_point step_time) -> void;
+  auto on_presented (clock::time_point present_time) -> void;
+
+  auto percentile (input_kind kind, unsigned int percent) const -> float;
+  auto print () const -> void;
+  auto write_csv (const char *path) const -> bool;
+
+private:
+  /**@brief an input whose result isn't on screen yet
+   */
+  struct pending_input
+  {
+    input_kind kind;
+    uint32_t sequence; // of the hand over to the simulation
+    bool consumed;
+    clock::time_point event_time;
+    clock::time_point poll_time;
+    clock::time_point step_time;
+  };
+
+  std::array<pending_input, max_pending> m_pending;
+  int m_pending_num;
+  uint32_t m_dropped; // inputs not measured because too many were pending
+  std::array<latency_histogram, static_cast<int> (input_kind::count)>
+      m_histograms;
+};
+
+#endif /* INPUT_LATENCY_H */
@@ -0,0 +1,180 @@
+/**@file input_queue.cpp
+ * @brief contains functions that turn timed key presses into step inputs.
+ *
+ */
+
+#include "input_queue.hpp"
+#include <algorithm>
+
+/**@brief Convert a duration to simulation steps, to the nearest step
+ *
+ * @param ms duration in milliseconds
+ * @return number of steps, 0 for negative durations
+ */
+auto
+input_handling::steps_from_ms (int ms) -> int
+{
+  return std::max (0, (ms * game::steps_per_second + 500) / 1000);
+}
+
+/**@brief Constructor of input_queue class
+ */
+input_queue::input_queue ()
+    : m_events (), m_head (0), m_tail (0), m_handling (), m_held (),
+      m_shift (0), m_shift_steps (0), m_soft_drop_steps (0)
+{
+}
+
+/**@brief Change how held buttons repeat, only to be used by the consumer
+ *
+ * @param handling delays and rates in steps, the rates are at least 1 step
+ * @return void
+ */
+auto
+input_queue::set_handling (const input_handling &handling) -> void
+{
+  m_handling.das_steps = std::max (handling.das_steps, 0);
+  m_handling.arr_steps = std::max (handling.arr_steps, 1);
+  m_handling.soft_drop_steps = std::max (handling.soft_drop_steps, 1);
+}
+
+/**@brief Add the press or release of a button, events are pushed in the
+ * order they happened
+ *
+ * @param button pressed or released
+ * @param pressed true for a press, false for a release
+ * @param time of the event
+ * @return true if the event was queued, false if the queue is full
+ */
+auto
+input_queue::push (input_button button, bool pressed, clock::time_point time)
+    -> bool
+{
+  const auto tail = m_tail.load (std::memory_order_relaxed);
+  if (tail - m_head.load (std::memory_order_acquire) == capacity)
+    return false;
+  m_events[tail % capacity] = { button, pressed, time };
+  m_tail.store (tail + 1, std::memory_order_release);
+  return true;
+}
+
+/**@brief Take the input of the next simulation step
+ *
+ * Consumes the events that happened before the end of the step, up to a
+ * second press of a button already pressed in the step, which is left for
+ * the next step. Then repeats the held move and soft drop.
+ *
+ * @param step_end time the step ends
+ * @return input of the step
+ */
+auto
+input_queue::next_step (clock::time_point step_end) -> game_input
+{
+  game_input input = {};
+  std::array<bool, static_cast<int> (input_button::count)> pressed = {};
+
+  auto head = m_head.load (std::memory_order_relaxed);
+  const auto tail = m_tail.load (std::memory_order_acquire);
+  for (; head != tail; ++head)
+    {
+      const auto &event = m_events[head % capacity];
+      const auto button = static_cast<int> (event.m_button);
+      if (event.m_time > step_end || (event.m_pressed && pressed[button]))
+        break;
+      pressed[button] = pressed[button] || event.m_pressed;
+      apply (event, input);
+    }
+  m_head.store (head, std::memory_order_release);
+
+  // the held move repeats after the delayed auto shift, at the auto repeat
+  // rate. The step it was pressed in already moved
+  const auto shift_button
+      = m_shift < 0 ? input_button::move_left : input_button::move_right;
+  if (m_shift != 0 && !pressed[static_cast<int> (shift_button)])
+    {
+      ++m_shift_steps;
+      const auto repeat_steps = m_shift_steps - m_handling.das_steps;
+      if (repeat_steps >= 0 && repeat_steps % m_handling.arr_steps == 0)
+        {
+          input.m_move_left = input.m_move_left || m_shift < 0;
+          input.m_move_right = input.m_move_right || m_shift > 0;
+        }
+    }
+
+  if (m_held[static_cast<int> (input_button::soft_drop)]
+      && !pressed[static_cast<int> (input_button::soft_drop)])
+    {
+      ++m_soft_drop_steps;
+      if (m_soft_drop_steps % m_handling.soft_drop_steps == 0)
+        input.m_soft_drop = true;
+    }
+  return input;
+}
+
+/**@brief Apply a press or release to the held buttons and to the input of
+ * the step
+ *
+ * The last move pressed is the one that repeats, releasing it hands the
+ * repeat over to the other move if it is still held (after a new delay).
+ *
+ * @param event to apply
+ * @param input of the step
+ * @return void
+ */
+auto
+input_queue::apply (const input_event &event, game_input &input) -> void
+{
+  m_held[static_cast<int> (event.m_button)] = event.m_pressed;
+  if (!event.m_pressed)
+    {
+      const auto left_held
+          = m_held[static_cast<int> (input_button::move_left)];
+      const auto right_held
+          = m_held[static_cast<int> (input_button::move_right)];
+      if ((event.m_button == input_button::move_left && m_shift < 0)
+          || (event.m_button == input_button::move_right && m_shift > 0))
+        {
+          m_shift = left_held ? -1 : right_held ? 1 : 0;
+          m_shift_steps = 0;
+        }
+      return;
+    }
+
+  switch (event.m_button)
+    {
+    case input_button::start:
+      input.m_start = true;
+      break;
+    case input_button::pause:
+      input.m_pause = true;
+      break;
+    case input_button::move_left:
+      input.m_move_left = true;
+      m_shift = -1;
+      m_shift_steps = 0;
+      break;
+    case input_button::move_right:
+      input.m_move_right = true;
+      m_shift = 1;
+      m_shift_steps = 0;
+      break;
+    case input_button::rotate_clockwise:
+      input.m_rotate_clockwise = true;
+      break;
+    case input_button::rotate_anticlockwise:
+      input.m_rotate_anticlockwise = true;
+      break;
+    case input_button::hard_drop:
+      input.m_hard_drop = true;
+      break;
+    case input_button::soft_drop:
+      input.m_soft_drop = true;
+      m_soft_drop_steps = 0;
+      break;
+    case input_button::reset:
+      input.m_reset = true;
+      break;
+    case input_button::count:
+      break;
+    }
+}
@@ -0,0 +1,114 @@
+/**@file input_queue.hpp
+ * @brief contains function prototypes for the input queue
+ *
+ * The frontend pushes every key press and release with the time it happened,
+ * the simulation turns them into the game_input of every step: an event
+ * belongs to the first step that ends after it, and a button pressed again
+ * within a step waits for the next step instead of being lost. Held moves
+ * and soft drops repeat on their own, counted in steps (delayed auto shift,
+ * then auto repeat rate), so neither depends on the key repeat of the OS nor
+ * on the frame rate, and replays record the moves they produce.
+ *
+ * One thread pushes and one thread (possibly another) takes the steps, the
+ * queue is a lock-free ring of fixed capacity.
+ */
+
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include "game.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**@brief buttons of the game, one per field of game_input
+ */
+enum class input_button : uint8_t
+{
+  start,
+  pause,
+  move_left,
+  move_right,
+  rotate_clockwise,
+  rotate_anticlockwise,
+  hard_drop,
+  soft_drop,
+  reset,
+  count,
+};
+
+/**@brief how held buttons repeat, in simulation steps
+ */
+struct input_handling
+{
+  int das_steps = 10; // a held move repeats after that many steps
+  int arr_steps = 2;  // and then every that many steps (at least 1)
+  int soft_drop_steps = 2; // a held soft drop drops every that many steps
+
+  static auto steps_from_ms (int ms) -> int;
+};
+
+/**@brief a press or release of a button
+ */
+struct input_event
+{
+  input_button m_button;
+  bool m_pressed;
+  std::chrono::steady_clock::time_point m_time;
+};
+
+class input_queue
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto capacity = 256u; // a power of 2
+
+  input_queue ();
+
+  input_queue (const input_queue &) = delete;
+  input_queue &operator= (const input_queue &) = delete;
+
+  auto set_handling (const input_handling &handling) -> void;
+
+  // producer
+  auto push (input_button button, bool pressed, clock::time_point time)
+      -> bool;
+
+  // consumer
+  auto next_step (clock::time_point step_end) -> game_input;
+
+  // getters
+  /**@brief number of events pushed so far, wraps around
+   */
+  auto
+  get_pushed () const -> uint32_t
+  {
+    return m_tail.load (std::memory_order_relaxed);
+  }
+
+  /**@brief number of events consumed by steps so far, wraps around
+   */
+  auto
+  get_consumed () const -> uint32_t
+  {
+    return m_head.load (std::memory_order_relaxed);
+  }
+
+private:
+  auto apply (const input_event &event, game_input &input) -> void;
+
+  std::array<input_event, capacity> m_events;
+  std::atomic<uint32_t> m_head; // next event to consume
+  std::atomic<uint32_t> m_tail; // next free slot
+
+  // state of the consumer
+  input_handling m_handling;
+  std::array<bool, static_cast<int> (input_button::count)> m_held;
+  int m_shift;       // direction of the held move: -1, 0 or 1
+  int m_shift_steps; // steps since the held move was pressed
+  int m_soft_drop_steps; // steps since the soft drop was pressed
+};
+
+#endif /* INPUT_QUEUE_H */
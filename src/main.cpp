@@ -5,8 +5,167 @@
  */
 
 #include "app.hpp"
+#include "asset_pack.hpp"
+#include "game_renderer.hpp"
+#include "replay.hpp"
+#include "software_renderer.hpp"
 #include <SDL2/SDL.h>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+/** @brief Re-simulate a replay without opening a window
+ *
+ *  @param path of the replay
+ *  @return 0 if the replay reproduced the recorded game, 1 otherwise
+ */
+static int
+verify_replay (const char *path)
+{
+  std::vector<uint8_t> replay_data;
+  if (!read_replay_file (path, replay_data))
+    {
+      fprintf (stderr, "Failed to read replay %s\n", path);
+      return 1;
+    }
+
+  game replayed_game;
+  uint64_t divergent_step = 0;
+  const auto start = std::chrono::steady_clock::now ();
+  const auto matches
+      = simulate_replay (replay_data, replayed_game, &divergent_step);
+  const auto seconds = std::chrono::duration<double> (
+                           std::chrono::steady_clock::now () - start)
+                           .count ();
+
+  replay_player player;
+  player.load (replay_data);
+  printf ("%s: %llu steps (%zu bytes) re-simulated in %.3f ms, %s\n", path,
+          static_cast<unsigned long long> (player.get_steps ()),
+          replay_data.size (), seconds * 1000.0,
+          matches ? "matches the recorded game" : "DIFFERS from the recording");
+  if (divergent_step)
+    printf ("first differing checkpoint at step %llu (checkpoints every %u "
+            "steps)\n",
+            static_cast<unsigned long long> (divergent_step),
+            player.get_checkpoint_interval ());
+  return matches ? 0 : 1;
+}
+
+/** @brief Render the last frame of a replay without opening a window
+ *
+ *  The frame is drawn by the software renderer at the logical size of the
+ *  application, so the image can be compared against a golden image.
+ *
+ *  @param path of the replay
+ *  @param path of the PPM image written
+ *  @return 0 if the image was written, 1 otherwise
+ */
+static int
+render_replay (const char *path, const char *image_path)
+{
+  std::vector<uint8_t> replay_data;
+  if (!read_replay_file (path, replay_data))
+    {
+      fprintf (stderr, "Failed to read replay %s\n", path);
+      return 1;
+    }
+
+  game replayed_game;
+  if (!simulate_replay (replay_data, replayed_game))
+    fprintf (stderr, "%s doesn't match the recorded game\n", path);
+
+  software_renderer image_renderer (1280, 720);
+  game_renderer replay_renderer;
+  image_renderer.clear ();
+  replay_renderer.draw (image_renderer, replayed_game.view (), 0.0f);
+  image_renderer.present ();
+  return image_renderer.write_ppm (image_path) ? 0 : 1;
+}
+
+/** @brief Parse the command line
+ *
+ *  --seed N               seed of the game (random by default)
+ *  --record FILE          record every input to FILE
+ *  --replay FILE          play back the inputs recorded in FILE
+ *  --verify-replay FILE   re-simulate FILE headless and check the result
+ *  --render-replay FILE IMAGE
+ *                         render the last frame of FILE to the PPM IMAGE
+ *  --frame-csv FILE       save the timings of the last frames to FILE
+ *  --trace FILE           save the trace zones to FILE (Chrome JSON)
+ *  --sim-thread           step the game on a thread of its own (native only)
+ *  --startup-csv FILE     append the startup timings to FILE on exit
+ *  --quit-after-startup   exit once the startup is over
+ *  --input-latency FILE   measure the input latency, save it to FILE
+ *  --das MS               delay before a held move repeats
+ *  --arr MS               delay between the repeats of a held move
+ *  --make-pack PACK FILE...
+ *                         pack the FILEs (every argument left) into PACK
+ *
+ *  @param number of arguments
+ *  @param arguments
+ *  @param options filled from the arguments
+ *  @param replay to verify instead of running the application, or null
+ *  @param replay to render instead of running the application, or null
+ *  @param image the rendered replay is written to
+ *  @param index of the pack to make in the arguments, followed by the files
+ *  to pack, or 0
+ *  @return false if the command line is invalid
+ */
+static bool
+parse_options (int argc, char *argv[], application::app_options &options,
+               const char *&verify_path, const char *&render_path,
+               const char *&image_path, int &pack_arg)
+{
+  for (int i = 1; i < argc; ++i)
+    {
+      const bool has_value = i + 1 < argc;
+      if (!strcmp (argv[i], "--seed") && has_value)
+        options.seed = strtoull (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--record") && has_value)
+        options.record_path = argv[++i];
+      else if (!strcmp (argv[i], "--replay") && has_value)
+        options.replay_path = argv[++i];
+      else if (!strcmp (argv[i], "--verify-replay") && has_value)
+        verify_path = argv[++i];
+      else if (!strcmp (argv[i], "--render-replay") && i + 2 < argc)
+        {
+          render_path = argv[++i];
+          image_path = argv[++i];
+        }
+      else if (!strcmp (argv[i], "--frame-csv") && has_value)
+        options.frame_csv_path = argv[++i];
+      else if (!strcmp (argv[i], "--trace") && has_value)
+        options.trace_path = argv[++i];
+      else if (!strcmp (argv[i], "--sim-thread"))
+        options.sim_thread = true;
+      else if (!strcmp (argv[i], "--startup-csv") && has_value)
+        options.startup_csv_path = argv[++i];
+      else if (!strcmp (argv[i], "--quit-after-startup"))
+        options.quit_after_startup = true;
+      else if (!strcmp (argv[i], "--input-latency") && has_value)
+        options.input_latency_path = argv[++i];
+      else if (!strcmp (argv[i], "--das") && has_value)
+        options.handling.das_steps
+            = input_handling::steps_from_ms (atoi (argv[++i]));
+      else if (!strcmp (argv[i], "--arr") && has_value)
+        options.handling.arr_steps
+            = input_handling::steps_from_ms (atoi (argv[++i]));
+      else if (!strcmp (argv[i], "--make-pack") && has_value)
+        {
+          pack_arg = i + 1;
+          break;
+        }
+      else
+        {
+          fprintf (stderr, "Unknown option %s\n", argv[i]);
+          return false;
+        }
+    }
+  return true;
+}
 
 /** @brief entry point of the program
  *
@@ -16,12 +175,31 @@
  *  @return 0 in case of successfull execution, any other number otherwise
  */
 int
-main ()
+main (int argc, char *argv[])
 {
   constexpr unsigned int disp_width = 1024;
   constexpr unsigned int disp_height = 576;
 
-  if (!application::init_app (disp_width, disp_height))
+  application::app_options options = {};
+  options.seed = std::random_device () ();
+  const char *verify_path = nullptr;
+  const char *render_path = nullptr;
+  const char *image_path = nullptr;
+  int pack_arg = 0;
+  if (!parse_options (argc, argv, options, verify_path, render_path,
+                      image_path, pack_arg))
+    return 1;
+  if (pack_arg)
+    return write_asset_pack (argv[pack_arg], argv + pack_arg + 1,
+                             argc - pack_arg - 1)
+               ? 0
+               : 1;
+  if (verify_path)
+    return verify_replay (verify_path);
+  if (render_path)
+    return render_replay (render_path, image_path);
+
+  if (!application::init_app (disp_width, disp_height, options))
     {
       printf ("ERROR - App failed to initialise\n");
       application::shut_down_app ();
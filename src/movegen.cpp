@@ -0,0 +1,256 @@
+/**@file movegen.cpp
+ * @brief contains the functions that enumerate the placements of a tetromino.
+ *
+ */
+
+#include "movegen.hpp"
+#include <algorithm>
+
+// positions of a board row where a tetromino box fits (see is_overlap ())
+static constexpr board_row valid_positions
+    = (board_row (1) << (sizeof (board_row) * 8 - tetromino::block_num + 1))
+      - 1;
+
+/**@brief Identify the cells covered by a tetromino
+ *
+ * Rotations of symmetric tetrominos (O, S, Z and I) cover the same cells from
+ * different positions, placements covering the same cells get the same key.
+ *
+ * @param board the tetromino is on, at most 65536 cells
+ * @param tetromino instance, must not overlap the board
+ * @return the sorted cell indices of the blocks packed in 16 bits each
+ */
+static auto
+placement_key (const board &p_board, const tetromino_instance &p_instance)
+    -> uint64_t
+{
+  const auto &block_coords
+      = tetromino_data[static_cast<int> (p_instance.m_tetromino_type)]
+            .block_coords[p_instance.m_rotation];
+  uint16_t cells[tetromino::block_num];
+  for (auto i = 0u; i < tetromino::block_num; ++i)
+    {
+      const auto x = p_instance.m_pos.x + block_coords[i].x;
+      const auto y = p_instance.m_pos.y + block_coords[i].y;
+      cells[i] = static_cast<uint16_t> (y * p_board.width + x);
+    }
+  std::sort (cells, cells + tetromino::block_num);
+
+  uint64_t key = 0;
+  for (auto cell : cells)
+    key = (key << 16) | cell;
+  return key;
+}
+
+/**@brief Extend positions of a row with every shift left and right
+ *
+ * @param reachable positions
+ * @param free positions of the same rotation and row
+ * @return the positions reachable by shifting without overlapping
+ */
+static auto
+shift_closure (board_row reachable, board_row free) -> board_row
+{
+  board_row previous;
+  do
+    {
+      previous = reachable;
+      reachable |= ((reachable << 1) | (reachable >> 1)) & free;
+    }
+  while (reachable != previous);
+  return reachable;
+}
+
+/**@brief Rotate positions of a row the way rotate_tetromino () does
+ *
+ * @param positions before the rotation
+ * @param free positions of the rotated tetromino in the same row
+ * @return positions after the rotation, rotations that don't fit are dropped
+ */
+static auto
+rotate_positions (board_row positions, board_row free) -> board_row
+{
+  const auto in_place = positions & free;
+  auto blocked = positions & ~free;
+  const auto kicked_left = (blocked >> 1) & free;
+  blocked &= ~(kicked_left << 1);
+  const auto kicked_right = (blocked << 1) & free;
+  return in_place | kicked_left | kicked_right;
+}
+
+/**@brief Default constructor of move_generator class
+ */
+move_generator::move_generator () : m_rows (0) {}
+
+/**@brief Find where a tetromino fits for every rotation and row
+ *
+ * A position collides if any row of the tetromino box meets a filled bit of
+ * the board row it covers, which is found for every column at once by
+ * shifting the board row by each block of the tetromino row.
+ *
+ * @param board on which the tetromino moves
+ * @param type of the tetromino
+ * @param first row of the search
+ * @return void
+ */
+auto
+move_generator::compute_free_positions (const board &p_board,
+                                        tetromino_type type, int spawn_y)
+    -> void
+{
+  const auto height = static_cast<int> (p_board.height);
+  for (auto rotation = 0u; rotation < tetromino::rotation_num; ++rotation)
+    {
+      const auto &shape = tetromino_shapes[static_cast<int> (type)][rotation];
+      for (auto row = 0; row < m_rows; ++row)
+        {
+          board_row collisions = 0;
+          for (auto i = 0u; i < tetromino::block_num; ++i)
+            {
+              const auto mask = shape.row_masks[i];
+              if (!mask)
+                continue;
+              const auto y = spawn_y + row + static_cast<int> (i);
+              if (y < 0 || y >= height)
+                {
+                  collisions = ~board_row (0);
+                  break;
+                }
+              for (auto bits = mask; bits; bits &= bits - 1)
+                collisions |= p_board.rows[y] >> __builtin_ctz (bits);
+            }
+          m_free[rotation * m_rows + row] = ~collisions & valid_positions;
+        }
+    }
+}
+
+/**@brief Enumerate every position where a tetromino can lock
+ *
+ * Explores the moves of the game from the spawn position: shift left or
+ * right, rotate either way (with kicks) and soft drop. Each row is solved
+ * for every column at once on bit masks: shifts and rotations are repeated
+ * until nothing new is reached, then the positions move down to the next row
+ * (nothing ever moves up). Every reachable position that can't move down is a
+ * placement, so tucks under overhangs and spins are found as well.
+ * Placements covering the same cells are only listed once.
+ *
+ * @param board on which the tetromino moves
+ * @param position the tetromino enters the board at
+ * @return the placements, valid until the next call. Empty if the spawn
+ * position is blocked.
+ */
+auto
+move_generator::generate (const board &p_board,
+                          const tetromino_instance &p_spawn)
+    -> const std::vector<placement> &
+{
+  m_keyed_placements.clear ();
+  m_placements.clear ();
+  if (is_overlap (p_spawn, p_board))
+    return m_placements;
+
+  const auto spawn_y = p_spawn.m_pos.y;
+  m_rows = static_cast<int> (p_board.height) - spawn_y;
+  m_free.resize (tetromino::rotation_num * m_rows);
+  m_reachable.assign (tetromino::rotation_num * m_rows, 0);
+  m_dropped.resize (tetromino::rotation_num * m_rows);
+  compute_free_positions (p_board, p_spawn.m_tetromino_type, spawn_y);
+
+  m_reachable[p_spawn.m_rotation * m_rows]
+      = board_row (1) << (p_spawn.m_pos.x + board::wall_bits);
+  for (auto row = 0; row < m_rows; ++row)
+    {
+      if (row > 0)
+        {
+          for (auto rotation = 0u; rotation < tetromino::rotation_num;
+               ++rotation)
+            {
+              const auto index = rotation * m_rows + row;
+              m_reachable[index] = m_reachable[index - 1] & m_free[index];
+              m_dropped[index] = m_dropped[index - 1] & m_free[index];
+            }
+        }
+
+      auto changed = true;
+      while (changed)
+        {
+          changed = false;
+          for (auto rotation = 0u; rotation < tetromino::rotation_num;
+               ++rotation)
+            {
+              const auto index = rotation * m_rows + row;
+              m_reachable[index]
+                  = shift_closure (m_reachable[index], m_free[index]);
+            }
+          for (auto rotation = 0u; rotation < tetromino::rotation_num;
+               ++rotation)
+            {
+              const auto positions = m_reachable[rotation * m_rows + row];
+              for (auto clockwise : { true, false })
+                {
+                  const auto target
+                      = (rotation
+                         + (clockwise ? tetromino::rotation_num - 1 : 1))
+                        % tetromino::rotation_num;
+                  auto &reachable = m_reachable[target * m_rows + row];
+                  const auto rotated = rotate_positions (
+                      positions, m_free[target * m_rows + row]);
+                  if (rotated & ~reachable)
+                    {
+                      reachable |= rotated;
+                      changed = true;
+                    }
+                }
+            }
+        }
+
+      // whatever is reached on the spawn row can be hard dropped
+      if (row == 0)
+        {
+          for (auto rotation = 0u; rotation < tetromino::rotation_num;
+               ++rotation)
+            m_dropped[rotation * m_rows] = m_reachable[rotation * m_rows];
+        }
+    }
+
+  for (auto rotation = 0u; rotation < tetromino::rotation_num; ++rotation)
+    {
+      for (auto row = 0; row < m_rows; ++row)
+        {
+          const auto index = rotation * m_rows + row;
+          const auto below = row + 1 < m_rows ? m_free[index + 1] : 0;
+          const auto landed = m_reachable[index] & ~below;
+          for (auto bits = landed; bits; bits &= bits - 1)
+            {
+              const auto bit = __builtin_ctz (bits);
+              placement landing = {};
+              landing.m_landing.m_tetromino_type = p_spawn.m_tetromino_type;
+              landing.m_landing.m_rotation = rotation;
+              landing.m_landing.m_pos
+                  = coords (bit - board::wall_bits, spawn_y + row);
+              landing.m_needs_soft_drop
+                  = !(m_dropped[index] & (board_row (1) << bit));
+              m_keyed_placements.push_back (
+                  { placement_key (p_board, landing.m_landing), landing });
+            }
+        }
+    }
+
+  // one placement per set of cells, preferring those reached by hard drops
+  std::sort (m_keyed_placements.begin (), m_keyed_placements.end (),
+             [] (const keyed_placement &a, const keyed_placement &b) {
+               if (a.first != b.first)
+                 return a.first < b.first;
+               if (a.second.m_needs_soft_drop != b.second.m_needs_soft_drop)
+                 return b.second.m_needs_soft_drop;
+               return a.second.m_landing.m_rotation
+                      < b.second.m_landing.m_rotation;
+             });
+  for (auto i = 0u; i < m_keyed_placements.size (); ++i)
+    {
+      if (i == 0
+          || m_keyed_placements[i].first != m_keyed_placements[i - 1].first)
+        m_placements.push_back (m_keyed_placements[i].second);
+    }
+  return m_placements;
+}
@@ -0,0 +1,51 @@
+/**@file movegen.hpp
+ * @brief contains function prototypes for move generation
+ *
+ * The move generator answers "where can this tetromino land?" for bots,
+ * hints and analysis. It uses the moves of the game (shift, rotation with
+ * kicks and soft drop, see game::update_playing) so every placement it finds
+ * can be reached by a player.
+ */
+
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "board.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**@brief final position of a tetromino, right before it locks
+ */
+struct placement
+{
+  tetromino_instance m_landing;
+  bool m_needs_soft_drop; // false if a hard drop from the spawn row reaches it
+};
+
+class move_generator
+{
+public:
+  move_generator ();
+
+  auto generate (const board &p_board, const tetromino_instance &p_spawn)
+      -> const std::vector<placement> &;
+
+private:
+  using keyed_placement = std::pair<uint64_t, placement>;
+
+  auto compute_free_positions (const board &p_board, tetromino_type type,
+                               int spawn_y) -> void;
+
+  // per rotation and row (rotation * rows + y - spawn row): bit
+  // wall_bits + x is set for the columns x of a position, the storage is kept
+  // between calls so that generating doesn't allocate once warm
+  int m_rows;
+  std::vector<board_row> m_free;      // positions that don't overlap
+  std::vector<board_row> m_reachable; // positions the tetromino can reach
+  std::vector<board_row> m_dropped;   // positions reached without soft drop
+  std::vector<keyed_placement> m_keyed_placements;
+  std::vector<placement> m_placements;
+};
+
+#endif /* MOVEGEN_H */
@@ -0,0 +1,200 @@
+/**@file music.cpp
+ * @brief contains functions that load and stream the background music.
+ *
+ */
+
+#include "music.hpp"
+#include "trace.hpp"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <cstdio>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+/**@brief Constructor of background_music class
+ */
+background_music::background_music ()
+    : m_paths (nullptr), m_path_num (0), m_next_path (0), m_music (nullptr),
+      m_data (), m_start_time (), m_stats ()
+{
+}
+
+/**@brief Destructor of background_music class
+ */
+background_music::~background_music () { stop (); }
+
+/**@brief Start loading the music, it plays as soon as it is loaded
+ *
+ * The tracks are tried in order until one of them plays, so a compressed
+ * track can be listed first and an uncompressed one as a fallback. Native
+ * builds open the track right away, web builds download it in the background
+ * and return at once.
+ *
+ * @param paths of the tracks, they must outlive the music
+ * @param number of paths
+ * @return void
+ */
+auto
+background_music::start (const char *const *paths, int path_num) -> void
+{
+  stop ();
+  m_paths = paths;
+  m_path_num = path_num;
+  m_next_path = 0;
+  m_start_time = clock::now ();
+  m_stats = {};
+  try_next ();
+}
+
+/**@brief Play a track that is already in memory
+ *
+ * @param name of the track, for the reports
+ * @param data of the track, it must outlive the music
+ * @param size of the data
+ * @return true if the track plays, false otherwise
+ */
+auto
+background_music::start (const char *name, const uint8_t *data,
+                         std::size_t size) -> bool
+{
+  stop ();
+  m_start_time = clock::now ();
+  m_stats = {};
+  auto *const source = SDL_RWFromConstMem (data, static_cast<int> (size));
+  if (!play (name, Mix_LoadMUS_RW (source, 1)))
+    {
+      fprintf (stderr, "Failed to load music %s: %s\n", name,
+               Mix_GetError ());
+      return false;
+    }
+  return true;
+}
+
+/**@brief Stop the music and free it, a download still running is ignored
+ * when it completes
+ *
+ * @return void
+ */
+auto
+background_music::stop () -> void
+{
+  if (m_music)
+    {
+      Mix_HaltMusic ();
+      Mix_FreeMusic (m_music);
+      m_music = nullptr;
+    }
+  m_paths = nullptr;
+  m_path_num = 0;
+  m_data.clear ();
+  m_data.shrink_to_fit ();
+}
+
+/**@brief Load the next track
+ *
+ * @return void
+ */
+auto
+background_music::try_next () -> void
+{
+  if (m_next_path >= m_path_num)
+    {
+      fprintf (stderr, "No background music could be played\n");
+      return;
+    }
+  const auto path = m_paths[m_next_path++];
+
+#ifdef __EMSCRIPTEN__
+  // fetched relative to the page, the track isn't part of the preloaded data
+  emscripten_async_wget_data (path, this, on_download, on_download_error);
+#else
+  TRACE_ZONE ("background_music::load");
+  // SDL_mixer reads the file as the track plays, nothing is loaded up front
+  if (!play (path, Mix_LoadMUS (path)))
+    fail ();
+#endif
+}
+
+/**@brief Play a loaded track
+ *
+ * @param name of the track
+ * @param music loaded by SDL_mixer, or null if it failed to load
+ * @return true if the track plays, false otherwise
+ */
+auto
+background_music::play (const char *name, Mix_Music *music) -> bool
+{
+  if (!music)
+    return false;
+  if (Mix_PlayMusic (music, -1) != 0)
+    {
+      Mix_FreeMusic (music);
+      return false;
+    }
+
+  m_music = music;
+  m_stats.path = name;
+  m_stats.resident = m_data.size ();
+  m_stats.ready_ms = std::chrono::duration<float, std::milli> (
+                         clock::now () - m_start_time)
+                         .count ();
+  printf ("Music %s playing after %.1f ms, %llu bytes downloaded, %llu "
+          "bytes resident\n",
+          m_stats.path, m_stats.ready_ms,
+          static_cast<unsigned long long> (m_stats.downloaded),
+          static_cast<unsigned long long> (m_stats.resident));
+  return true;
+}
+
+/**@brief Report the track that failed and try the next one
+ *
+ * @return void
+ */
+auto
+background_music::fail () -> void
+{
+  fprintf (stderr, "Failed to load music %s: %s\n", m_paths[m_next_path - 1],
+           Mix_GetError ());
+  m_data.clear ();
+  try_next ();
+}
+
+#ifdef __EMSCRIPTEN__
+/**@brief Play a downloaded track
+ *
+ * The data given by emscripten is freed when this returns, it is copied so
+ * that SDL_mixer can keep streaming from it.
+ */
+void
+background_music::on_download (void *arg, void *data, int size)
+{
+  auto &music = *static_cast<background_music *> (arg);
+  if (!music.m_paths)
+    return; // stopped while downloading
+
+  const auto bytes = static_cast<const uint8_t *> (data);
+  music.m_data.assign (bytes, bytes + size);
+  music.m_stats.downloaded += size;
+  auto *const source = SDL_RWFromConstMem (music.m_data.data (), size);
+  if (!music.play (music.m_paths[music.m_next_path - 1],
+                   Mix_LoadMUS_RW (source, 1)))
+    music.fail ();
+}
+
+/**@brief Try the next track when a download fails
+ */
+void
+background_music::on_download_error (void *arg)
+{
+  auto &music = *static_cast<background_music *> (arg);
+  if (!music.m_paths)
+    return;
+
+  fprintf (stderr, "Failed to download music %s\n",
+           music.m_paths[music.m_next_path - 1]);
+  music.try_next ();
+}
+#endif
@@ -0,0 +1,80 @@
+/**@file music.hpp
+ * @brief contains function prototypes for the background music
+ *
+ * The music is streamed by SDL_mixer: it is decoded a little at a time while
+ * it plays, only the compressed track (and on native builds not even that,
+ * it is read from the file as it plays) stays in memory. Web builds don't
+ * preload the track with the game, it is downloaded once the game is running
+ * and starts playing when it arrives. A track already in memory (from the
+ * asset pack) is streamed from there.
+ */
+
+#ifndef MUSIC_H
+#define MUSIC_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+typedef struct _Mix_Music Mix_Music;
+
+/**@brief what loading the music cost
+ */
+struct music_stats
+{
+  const char *path;       // track being played, or null
+  uint64_t downloaded;    // bytes downloaded (web builds only)
+  uint64_t resident;      // bytes of the track kept in memory
+  float ready_ms;         // from start () to the track playing
+};
+
+class background_music
+{
+public:
+  background_music ();
+  ~background_music ();
+
+  background_music (const background_music &) = delete;
+  background_music &operator= (const background_music &) = delete;
+
+  auto start (const char *const *paths, int path_num) -> void;
+  auto start (const char *name, const uint8_t *data, std::size_t size)
+      -> bool;
+  auto stop () -> void;
+
+  // getters
+  auto
+  is_playing () const -> bool
+  {
+    return m_music != nullptr;
+  }
+
+  auto
+  get_stats () const -> const music_stats &
+  {
+    return m_stats;
+  }
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  auto try_next () -> void;
+  auto play (const char *name, Mix_Music *music) -> bool;
+  auto fail () -> void;
+
+#ifdef __EMSCRIPTEN__
+  static void on_download (void *arg, void *data, int size);
+  static void on_download_error (void *arg);
+#endif
+
+  const char *const *m_paths; // tried in order until one plays
+  int m_path_num;
+  int m_next_path;
+  Mix_Music *m_music;
+  std::vector<uint8_t> m_data; // downloaded track the stream is read from
+  clock::time_point m_start_time;
+  music_stats m_stats;
+};
+
+#endif /* MUSIC_H */
@@ -0,0 +1,143 @@
+/**@file null_renderer.cpp
+ * @brief contains a renderer that draws nothing.
+ *
+ * Only layers are tracked, so that invalid layer indices are rejected like
+ * the other backends do.
+ */
+
+#include "null_renderer.hpp"
+
+/**@brief Constructor of the null renderer
+ *
+ * @param logical width of the screen
+ * @param logical height of the screen
+ */
+null_renderer::null_renderer (unsigned int width, unsigned int height)
+    : renderer (width, height), m_layer_num (0)
+{
+}
+
+/**@brief Bump the layer generation so that layer owners redraw, as after
+ * a real render reset
+ */
+auto
+null_renderer::on_render_reset (bool) -> void
+{
+  ++m_layer_generation;
+}
+
+/**@brief Create a layer, only its handle exists
+ *
+ * @return handle of the layer
+ */
+auto
+null_renderer::create_layer (int, int) -> int
+{
+  return m_layer_num++;
+}
+
+/**@brief Pretend to redirect drawing into the given layer
+ *
+ * @param handle of the layer
+ * @return true if the layer exists, false otherwise
+ */
+auto
+null_renderer::begin_layer (int layer) -> bool
+{
+  if (layer < 0 || layer >= m_layer_num)
+    return false;
+  ++m_frame_stats.draw_calls;
+  return true;
+}
+
+/**@brief Send drawing back to the screen, nothing to do
+ */
+auto
+null_renderer::end_layer () -> void
+{
+}
+
+/**@brief Count the blending of a layer on the screen
+ *
+ * @param handle of the layer, invalid handles are ignored
+ */
+auto
+null_renderer::draw_layer (int layer, const coords) -> void
+{
+  if (layer < 0 || layer >= m_layer_num)
+    return;
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief Count the clear of the screen
+ */
+auto
+null_renderer::clear () -> void
+{
+  ++m_frame_stats.draw_calls;
+}
+
+/**@brief Finish the frame and its statistics
+ */
+auto
+null_renderer::present () -> void
+{
+  end_frame_stats ();
+}
+
+/**@brief Count the outline of a rectangle
+ */
+auto
+null_renderer::draw_rectangle (const coords, const int, const int,
+                               const uint32_t) -> void
+{
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief Count a filled rectangle
+ */
+auto
+null_renderer::draw_filled_rectangle (const coords, const int, const int,
+                                      const uint32_t) -> void
+{
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief Count a batch of filled rectangles as a single draw call
+ *
+ * @param count of rectangles
+ */
+auto
+null_renderer::draw_filled_rectangles (const colored_rect *, std::size_t count)
+    -> void
+{
+  if (!count)
+    return;
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += count;
+}
+
+/**@brief Count a batch of blocks as a single draw call
+ *
+ * @param count of blocks
+ */
+auto
+null_renderer::draw_blocks (const block_quad *, std::size_t count) -> void
+{
+  if (!count)
+    return;
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += count;
+}
+
+/**@brief Count a line of text
+ */
+auto
+null_renderer::draw_text (const char *, const coords, const uint32_t) -> void
+{
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
@@ -0,0 +1,46 @@
+/**@file null_renderer.hpp
+ * @brief contains a render backend that draws nothing.
+ *
+ * Every draw call is accepted and counted in the frame stats but nothing is
+ * drawn, so the frontend runs without a window or a GPU, for example to
+ * benchmark game_renderer.
+ */
+
+#ifndef NULL_RENDERER_H
+#define NULL_RENDERER_H
+
+#include "renderer.hpp"
+
+class null_renderer : public renderer
+{
+public:
+  null_renderer (unsigned int width, unsigned int height);
+
+  auto clear () -> void override;
+  auto present () -> void override;
+
+  auto draw_rectangle (const coords loc, const int width, const int height,
+                       const uint32_t rgba_color) -> void override;
+  auto draw_filled_rectangle (const coords loc, const int width,
+                              const int height, const uint32_t rgba_color)
+      -> void override;
+  auto draw_filled_rectangles (const colored_rect *rects, std::size_t count)
+      -> void override;
+  auto draw_blocks (const block_quad *blocks, std::size_t count)
+      -> void override;
+  using renderer::draw_text;
+  auto draw_text (const char *text, const coords loc,
+                  const uint32_t rgba_color) -> void override;
+
+  auto create_layer (int width, int height) -> int override;
+  auto begin_layer (int layer) -> bool override;
+  auto end_layer () -> void override;
+  auto draw_layer (int layer, const coords loc) -> void override;
+
+  auto on_render_reset (bool device_lost) -> void override;
+
+private:
+  int m_layer_num;
+};
+
+#endif /* NULL_RENDERER_H */
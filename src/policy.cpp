@@ -0,0 +1,113 @@
+/**@file policy.cpp
+ * @brief contains the functions of the placement policy.
+ *
+ */
+
+#include "policy.hpp"
+#include <cstdlib>
+
+/**@brief Get weights that play reasonably well
+ *
+ * Taken from a well known hand tuned 4 feature player, a good starting point
+ * for tuning.
+ *
+ * @return weights of the default policy
+ */
+auto
+get_default_policy_weights () -> policy_weights
+{
+  policy_weights weights = {};
+  weights.values[static_cast<int> (board_feature::lines_cleared)] = 0.760666f;
+  weights.values[static_cast<int> (board_feature::aggregate_height)]
+      = -0.510066f;
+  weights.values[static_cast<int> (board_feature::holes)] = -0.35663f;
+  weights.values[static_cast<int> (board_feature::bumpiness)] = -0.184483f;
+  return weights;
+}
+
+/**@brief Constructor of placement_policy class
+ *
+ * @param weights of the board features
+ */
+placement_policy::placement_policy (const policy_weights &p_weights)
+    : m_weights (p_weights), m_scratch_board ()
+{
+}
+
+/**@brief Score a board without its lines cleared feature
+ *
+ * @param board after the placement and the line clear
+ * @return weighted sum of the height, hole and bumpiness features
+ */
+auto
+placement_policy::evaluate (const board &p_board) const -> float
+{
+  const auto height = static_cast<int> (p_board.height);
+  auto aggregate_height = 0;
+  auto bumpiness = 0;
+  for (auto x = 0u; x < p_board.width; ++x)
+    {
+      const auto column_height = height - p_board.column_tops[x];
+      aggregate_height += column_height;
+      if (x > 0)
+        bumpiness += std::abs (column_height
+                               - (height - p_board.column_tops[x - 1]));
+    }
+
+  // a cell is a hole if a filled cell of its column was seen above it
+  const auto cells = ~p_board.empty_row;
+  board_row covered = 0;
+  auto holes = 0;
+  for (auto y = 0u; y < p_board.height; ++y)
+    {
+      holes += __builtin_popcount (~p_board.rows[y] & covered & cells);
+      covered |= p_board.rows[y];
+    }
+
+  const auto *weights = m_weights.values;
+  return weights[static_cast<int> (board_feature::aggregate_height)]
+             * aggregate_height
+         + weights[static_cast<int> (board_feature::holes)] * holes
+         + weights[static_cast<int> (board_feature::bumpiness)] * bumpiness;
+}
+
+/**@brief Pick the best placement of a tetromino
+ *
+ * Every placement is locked on a copy of the board, the one with the highest
+ * score after its line clear wins (the first one found on ties).
+ *
+ * @param board on which the tetromino is placed
+ * @param position the tetromino enters the board at
+ * @param choice the chosen placement
+ * @return true if a placement was chosen, false if there is none (the
+ * tetromino can't enter the board).
+ */
+auto
+placement_policy::choose (const board &p_board,
+                          const tetromino_instance &p_spawn,
+                          placement &p_choice) -> bool
+{
+  const auto &placements = m_generator.generate (p_board, p_spawn);
+  const auto lines_weight
+      = m_weights.values[static_cast<int> (board_feature::lines_cleared)];
+
+  auto best_score = 0.0f;
+  auto found = false;
+  for (const auto &candidate : placements)
+    {
+      m_scratch_board = p_board;
+      lock_tetromino (m_scratch_board, candidate.m_landing);
+      const auto lines = clear_full_rows (m_scratch_board,
+                                          candidate.m_landing.m_pos.y,
+                                          tetromino::block_num);
+      const auto score
+          = lines_weight * lines.count + evaluate (m_scratch_board);
+      if (!found || score > best_score)
+        {
+          best_score = score;
+          p_choice = candidate;
+          found = true;
+        }
+    }
+  return found;
+}
@@ -0,0 +1,52 @@
+/**@file policy.hpp
+ * @brief contains function prototypes for the placement policy
+ *
+ * The placement policy plays the game on its own: it tries every placement
+ * found by the move generator and keeps the one leading to the best board,
+ * boards being scored by a weighted sum of features. The weights decide how
+ * well (and how) it plays, they can be tuned by selfplay.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "board.hpp"
+#include "movegen.hpp"
+
+/**@brief features of a board after a placement, weighted by the policy
+ */
+enum class board_feature
+{
+  lines_cleared,
+  aggregate_height, // sum of the column heights
+  holes,            // empty cells under a filled one
+  bumpiness,        // sum of height differences between neighbour columns
+  count,
+};
+
+struct policy_weights
+{
+  static constexpr auto feature_num = static_cast<int> (board_feature::count);
+
+  float values[feature_num];
+};
+
+auto get_default_policy_weights () -> policy_weights;
+
+class placement_policy
+{
+public:
+  explicit placement_policy (const policy_weights &p_weights);
+
+  auto choose (const board &p_board, const tetromino_instance &p_spawn,
+               placement &p_choice) -> bool;
+
+private:
+  auto evaluate (const board &p_board) const -> float;
+
+  policy_weights m_weights;
+  move_generator m_generator;
+  board m_scratch_board; // kept to reuse its storage
+};
+
+#endif /* POLICY_H */
@@ -1,35 +1,47 @@
 /**@file renderer.hpp
- * @brief contains function prototypes for renderer
+ * @brief contains the interface of the render backends
  *
- * This contains function prototypes for the renderer driver, which is
- * responsibe for drawing stuff on screen.
+ * Everything that draws (game_renderer, the frame overlay) goes through this
+ * interface, so the same drawing code runs on every backend:
  *
+ * - sdl_renderer draws on screen with SDL_Renderer
+ * - software_renderer rasterizes into an RGBA framebuffer in memory, for
+ *   headless machines, golden image tests and offline rendering
+ * - null_renderer only counts the draw calls, for benchmarks
  */
 
 #ifndef RENDERER_H
 #define RENDERER_H
 
 #include "utils.hpp"
-#include <SDL2/SDL_ttf.h>
+#include <cstddef>
 #include <string>
 
-class Texture;
-
-struct SDL_Window;
-struct SDL_Renderer;
+/**@brief number of calls submitted to the backend during a frame
+ */
+struct render_stats
+{
+  unsigned int draw_calls;
+  unsigned int primitives;
+};
 
 /**@class renderer
- * @brief wrapper around SDL renderer tailerd for this application.
+ * @brief drawing primitives of the game, implemented by every render backend
  *
+ * Colors are 0xRRGGBBAA. Rectangles replace the pixels they cover (alpha
+ * included), blocks, text and layers are alpha blended.
  */
 class renderer
 {
 public:
-  renderer (SDL_Window &window, unsigned int width, unsigned int height);
-  ~renderer ();
+  renderer (unsigned int width, unsigned int height);
+  virtual ~renderer () = default;
 
-  auto clear () -> void;
-  auto present () -> void;
+  renderer (const renderer &) = delete;
+  renderer &operator= (const renderer &) = delete;
+
+  virtual auto clear () -> void = 0;
+  virtual auto present () -> void = 0;
 
   // getters
   auto
@@ -43,23 +55,56 @@ public:
     return m_height;
   }
 
-  auto draw_rectangle (const coords loc, const int width, const int height,
-                       const uint32_t rgba_color) -> void;
-  auto draw_filled_rectangle (const coords loc, const int width,
-                              const int height, const uint32_t rgba_color)
-      -> void;
+  virtual auto draw_rectangle (const coords loc, const int width,
+                               const int height, const uint32_t rgba_color)
+      -> void
+      = 0;
+  virtual auto draw_filled_rectangle (const coords loc, const int width,
+                                      const int height,
+                                      const uint32_t rgba_color) -> void
+      = 0;
+  virtual auto draw_filled_rectangles (const colored_rect *rects,
+                                       std::size_t count) -> void
+      = 0;
+  virtual auto draw_blocks (const block_quad *blocks, std::size_t count)
+      -> void
+      = 0;
   auto draw_text (const std::string &text, const coords loc,
                   const uint32_t rgba_color) -> void;
-  auto draw_text (const char *text, const coords loc, const uint32_t rgba_color)
-      -> void;
+  virtual auto draw_text (const char *text, const coords loc,
+                          const uint32_t rgba_color) -> void
+      = 0;
+
+  virtual auto create_layer (int width, int height) -> int = 0;
+  virtual auto begin_layer (int layer) -> bool = 0;
+  virtual auto end_layer () -> void = 0;
+  virtual auto draw_layer (int layer, const coords loc) -> void = 0;
+  auto
+  get_layer_generation () const
+  {
+    return m_layer_generation;
+  }
+
+  virtual auto on_render_reset (bool device_lost) -> void;
+  auto
+  get_frame_stats () const
+  {
+    return m_last_frame_stats;
+  }
+
+protected:
+  auto end_frame_stats () -> void;
 
-private:
   unsigned int m_width;
   unsigned int m_height;
 
-  SDL_Renderer *m_sdl_renderer;
+  // bumped when the contents of the layers are lost
+  unsigned int m_layer_generation;
 
-  TTF_Font *m_font;
+  render_stats m_frame_stats;
+  render_stats m_last_frame_stats;
+  unsigned long m_frame_num;
+  unsigned long m_total_draw_calls;
 };
 
 #endif /* RENDERER_H */
@@ -0,0 +1,421 @@
+/**@file replay.cpp
+ * @brief contains functions that record and play replays.
+ *
+ */
+
+#include "replay.hpp"
+#include <cstdio>
+#include <cstring>
+
+static constexpr char replay_magic[4] = { 'T', 'T', 'R', 'P' };
+static constexpr uint8_t replay_version = 2;
+
+// helpers
+
+/**@brief append an unsigned LEB128 varint
+ */
+static auto
+write_varint (std::vector<uint8_t> &data, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      data.push_back (static_cast<uint8_t> (value | 0x80));
+      value >>= 7;
+    }
+  data.push_back (static_cast<uint8_t> (value));
+}
+
+/**@brief read an unsigned LEB128 varint
+ *
+ * @param buffer to read from
+ * @param offset of the varint, moved past it
+ * @param value read
+ * @return false if the buffer ends before the varint does
+ */
+static auto
+read_varint (const std::vector<uint8_t> &data, std::size_t &offset,
+             uint64_t &value)
+{
+  value = 0;
+  for (auto shift = 0u; shift < 64; shift += 7)
+    {
+      if (offset >= data.size ())
+        return false;
+      const auto byte = data[offset++];
+      value |= static_cast<uint64_t> (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+  return false;
+}
+
+/**@brief read a little endian integer of the given number of bytes
+ *
+ * @return false if the buffer ends before the integer does
+ */
+static auto
+read_le (const std::vector<uint8_t> &data, std::size_t &offset,
+         unsigned int bytes, uint64_t &value)
+{
+  if (offset + bytes > data.size ())
+    return false;
+  value = 0;
+  for (auto i = 0u; i < bytes; ++i)
+    value |= static_cast<uint64_t> (data[offset++]) << (i * 8);
+  return true;
+}
+
+/**@brief append a little endian integer of the given number of bytes
+ */
+static auto
+write_le (std::vector<uint8_t> &data, unsigned int bytes, uint64_t value)
+{
+  for (auto i = 0u; i < bytes; ++i)
+    data.push_back (static_cast<uint8_t> (value >> (i * 8)));
+}
+
+/**@brief pack the input of a step in a bitfield
+ */
+auto
+pack_input (const game_input &input) -> uint16_t
+{
+  return static_cast<uint16_t> (
+      input.m_start << 0 | input.m_pause << 1 | input.m_move_left << 2
+      | input.m_move_right << 3 | input.m_rotate_clockwise << 4
+      | input.m_rotate_anticlockwise << 5 | input.m_hard_drop << 6
+      | input.m_soft_drop << 7 | input.m_reset << 8);
+}
+
+/**@brief unpack the input of a step from a bitfield
+ */
+auto
+unpack_input (uint16_t bits) -> game_input
+{
+  game_input input = {};
+  input.m_start = bits & (1 << 0);
+  input.m_pause = bits & (1 << 1);
+  input.m_move_left = bits & (1 << 2);
+  input.m_move_right = bits & (1 << 3);
+  input.m_rotate_clockwise = bits & (1 << 4);
+  input.m_rotate_anticlockwise = bits & (1 << 5);
+  input.m_hard_drop = bits & (1 << 6);
+  input.m_soft_drop = bits & (1 << 7);
+  input.m_reset = bits & (1 << 8);
+  return input;
+}
+
+/**@brief checksum of everything visible of a game
+ *
+ * FNV-1a over the board, active tetromino, next tetrominos and counters.
+ * @param game whose state is summarised
+ * @return the checksum
+ */
+auto
+game_checksum (const game &p_game) -> uint64_t
+{
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash] (uint64_t value) {
+    for (auto i = 0; i < 8; ++i)
+      {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 1099511628211ull;
+      }
+  };
+
+  const auto view = p_game.view ();
+  mix (static_cast<uint64_t> (view.m_state));
+  mix (view.m_game_seed);
+  mix (static_cast<uint64_t> (view.m_score));
+  mix (static_cast<uint64_t> (view.m_lines_cleared));
+  if (view.m_state != game_state::title_screen)
+    {
+      for (auto color : view.m_board->colors)
+        mix (color);
+      mix (static_cast<uint64_t> (view.m_active_tetromino.m_tetromino_type));
+      mix (static_cast<uint64_t> (view.m_active_tetromino.m_pos.x));
+      mix (static_cast<uint64_t> (view.m_active_tetromino.m_pos.y));
+      mix (view.m_active_tetromino.m_rotation);
+      for (auto type : view.m_next_tetrominos)
+        mix (static_cast<uint64_t> (type));
+    }
+  return hash;
+}
+
+// class replay_recorder
+
+/**@brief Constructor of replay_recorder class
+ *
+ * @param seed the recorded game was constructed with
+ * @param steps between two checkpoints of the game state, 0 for none
+ */
+replay_recorder::replay_recorder (uint64_t seed,
+                                  unsigned int checkpoint_interval)
+    : m_checkpoint_interval (checkpoint_interval), m_run_bits (0),
+      m_run_length (0), m_steps (0), m_finished (false)
+{
+  for (auto c : replay_magic)
+    m_data.push_back (static_cast<uint8_t> (c));
+  m_data.push_back (replay_version);
+  write_varint (m_data, seed);
+  write_varint (m_data, m_checkpoint_interval);
+}
+
+/**@brief Write the current run of identical inputs
+ */
+auto
+replay_recorder::flush_run () -> void
+{
+  if (!m_run_length)
+    return;
+  write_varint (m_data, m_run_bits);
+  write_varint (m_data, m_run_length);
+  m_run_length = 0;
+}
+
+/**@brief Record the input given to one step of the game
+ *
+ * @param input given to game::step ()
+ * @return void
+ */
+auto
+replay_recorder::record (const game_input &input) -> void
+{
+  if (m_finished)
+    return;
+
+  const auto bits = pack_input (input);
+  if (m_run_length && bits != m_run_bits)
+    flush_run ();
+  m_run_bits = bits;
+  ++m_run_length;
+  ++m_steps;
+}
+
+/**@brief Record a checkpoint if the last recorded step is due for one
+ *
+ * @param game right after the step whose input was last recorded
+ * @return void
+ */
+auto
+replay_recorder::record_state (const game &p_game) -> void
+{
+  if (m_finished || !m_checkpoint_interval || !m_steps
+      || m_steps % m_checkpoint_interval)
+    return;
+  m_checkpoints.push_back (static_cast<uint32_t> (p_game.state_hash ()));
+}
+
+/**@brief Terminate the replay
+ *
+ * @param game the inputs were given to, its final state is checksummed so
+ * that playback can be verified.
+ * @return encoded replay
+ */
+auto
+replay_recorder::finish (const game &p_game) -> const std::vector<uint8_t> &
+{
+  if (m_finished)
+    return m_data;
+
+  flush_run ();
+  write_varint (m_data, 0);
+  write_varint (m_data, 0);
+  write_varint (m_data, m_steps);
+  write_varint (m_data, m_checkpoints.size ());
+  for (auto checkpoint : m_checkpoints)
+    write_le (m_data, 4, checkpoint);
+  write_le (m_data, 8, game_checksum (p_game));
+  m_finished = true;
+  return m_data;
+}
+
+// class replay_player
+
+/**@brief Default Constructor of replay_player class
+ */
+replay_player::replay_player ()
+    : m_checkpoint_interval (0), m_played (0), m_divergent_step (0),
+      m_offset (0), m_run_bits (0), m_run_left (0), m_seed (0), m_steps (0),
+      m_checksum (0)
+{
+}
+
+/**@brief Load an encoded replay
+ *
+ * @param encoded replay, as given by replay_recorder::finish (), or a
+ * version 1 replay without checkpoints
+ * @return true if the replay is valid, false otherwise
+ */
+auto
+replay_player::load (const std::vector<uint8_t> &data) -> bool
+{
+  if (data.size () < 5 || std::memcmp (data.data (), replay_magic, 4) != 0
+      || data[4] < 1 || data[4] > replay_version)
+    return false;
+  const auto version = data[4];
+
+  std::size_t offset = 5;
+  uint64_t interval = 0;
+  if (!read_varint (data, offset, m_seed)
+      || (version >= 2 && !read_varint (data, offset, interval)))
+    return false;
+
+  // validate the runs and find the footer
+  const auto runs_begin = offset;
+  for (;;)
+    {
+      uint64_t bits, length;
+      if (!read_varint (data, offset, bits)
+          || !read_varint (data, offset, length))
+        return false;
+      if (!length)
+        break;
+    }
+  const auto runs_end = offset;
+
+  uint64_t checkpoint_num = 0;
+  if (!read_varint (data, offset, m_steps)
+      || (version >= 2 && !read_varint (data, offset, checkpoint_num))
+      || checkpoint_num > (data.size () - offset) / 4)
+    return false;
+  m_checkpoints.resize (checkpoint_num);
+  for (auto &checkpoint : m_checkpoints)
+    {
+      uint64_t value;
+      if (!read_le (data, offset, 4, value))
+        return false;
+      checkpoint = static_cast<uint32_t> (value);
+    }
+  if (!read_le (data, offset, 8, m_checksum))
+    return false;
+
+  m_runs.assign (data.begin () + runs_begin, data.begin () + runs_end);
+  m_checkpoint_interval = static_cast<unsigned int> (interval);
+  m_played = 0;
+  m_divergent_step = 0;
+  m_offset = 0;
+  m_run_left = 0;
+  return true;
+}
+
+/**@brief Get the input of the next step
+ *
+ * @param input of the next step
+ * @return false once every recorded step has been played
+ */
+auto
+replay_player::next (game_input &input) -> bool
+{
+  if (!m_run_left)
+    {
+      uint64_t bits;
+      if (!read_varint (m_runs, m_offset, bits)
+          || !read_varint (m_runs, m_offset, m_run_left) || !m_run_left)
+        return false;
+      m_run_bits = static_cast<uint16_t> (bits);
+    }
+  --m_run_left;
+  ++m_played;
+  input = unpack_input (m_run_bits);
+  return true;
+}
+
+/**@brief Compare a game with the checkpoint of the last played step, if any
+ *
+ * @param game right after the step whose input was last given by next ()
+ * @return false at the first checkpoint the game differs from, true
+ * otherwise (also at later checkpoints, see get_divergent_step ())
+ */
+auto
+replay_player::check (const game &p_game) -> bool
+{
+  if (m_divergent_step || !m_checkpoint_interval
+      || m_played % m_checkpoint_interval)
+    return true;
+  const auto index = m_played / m_checkpoint_interval - 1;
+  if (index >= m_checkpoints.size ()
+      || static_cast<uint32_t> (p_game.state_hash ()) == m_checkpoints[index])
+    return true;
+  m_divergent_step = m_played;
+  return false;
+}
+
+/**@brief Check a game against the recorded final state
+ *
+ * @param game every input of the replay was given to
+ * @return true if the game ended exactly as the recorded one did
+ */
+auto
+replay_player::matches (const game &p_game) const -> bool
+{
+  return game_checksum (p_game) == m_checksum;
+}
+
+/**@brief Re-simulate a whole replay as fast as possible
+ *
+ * @param encoded replay
+ * @param game to play the replay on, it is reconstructed with the seed of the
+ * replay.
+ * @param step of the first checkpoint that differed (0 if none did), the
+ * simulation stops there. May be null.
+ * @return true if the game ended exactly as the recorded one did
+ */
+auto
+simulate_replay (const std::vector<uint8_t> &data, game &p_game,
+                 uint64_t *p_divergent_step) -> bool
+{
+  replay_player player;
+  if (!player.load (data))
+    return false;
+
+  p_game = game (player.get_seed ());
+  game_input input;
+  auto in_sync = true;
+  while (in_sync && player.next (input))
+    {
+      p_game.step (input);
+      in_sync = player.check (p_game);
+    }
+  if (p_divergent_step)
+    *p_divergent_step = player.get_divergent_step ();
+  return in_sync && player.matches (p_game);
+}
+
+/**@brief Read a replay from a file
+ *
+ * @param path of the file
+ * @param contents of the file
+ * @return true if the file was read, false otherwise
+ */
+auto
+read_replay_file (const char *path, std::vector<uint8_t> &data) -> bool
+{
+  auto file = std::fopen (path, "rb");
+  if (!file)
+    return false;
+
+  data.clear ();
+  uint8_t buffer[4096];
+  std::size_t read;
+  while ((read = std::fread (buffer, 1, sizeof (buffer), file)) > 0)
+    data.insert (data.end (), buffer, buffer + read);
+  std::fclose (file);
+  return true;
+}
+
+/**@brief Write a replay to a file
+ *
+ * @param path of the file
+ * @param encoded replay
+ * @return true if the file was written, false otherwise
+ */
+auto
+write_replay_file (const char *path, const std::vector<uint8_t> &data) -> bool
+{
+  auto file = std::fopen (path, "wb");
+  if (!file)
+    return false;
+
+  const auto written = std::fwrite (data.data (), 1, data.size (), file);
+  return std::fclose (file) == 0 && written == data.size ();
+}
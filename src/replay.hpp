@@ -0,0 +1,116 @@
+/**@file replay.hpp
+ * @brief contains function prototypes for recording and playing replays
+ *
+ * A replay is the seed of the game followed by the input given to every
+ * simulation step, packed as run-length encoded varints. Since the game only
+ * depends on its seed and inputs, re-simulating a replay reproduces the
+ * recorded games exactly.
+ *
+ * Every checkpoint_interval steps the recorder also keeps the low 32 bits of
+ * game::state_hash (), so a player (or a simulation running elsewhere, like
+ * the wasm build) finds the first checkpoint where it diverged instead of
+ * only learning that the final state differs.
+ *
+ * Layout: "TTRP", version byte, varint seed, varint checkpoint interval,
+ * (varint input bits, varint run length)* , a run of length 0, varint number
+ * of steps, varint number of checkpoints, 4 bytes per checkpoint, 8 byte
+ * checksum of the final game state (integers little endian). Version 1 files
+ * have neither the interval nor the checkpoints.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.hpp"
+#include <cstdint>
+#include <vector>
+
+auto pack_input (const game_input &input) -> uint16_t;
+auto unpack_input (uint16_t bits) -> game_input;
+auto game_checksum (const game &p_game) -> uint64_t;
+
+/**@class replay_recorder
+ * @brief record the inputs given to a game
+ */
+class replay_recorder
+{
+public:
+  static constexpr auto default_checkpoint_interval
+      = static_cast<unsigned int> (game::steps_per_second);
+
+  explicit replay_recorder (
+      uint64_t seed,
+      unsigned int checkpoint_interval = default_checkpoint_interval);
+
+  auto record (const game_input &input) -> void;
+  auto record_state (const game &p_game) -> void;
+  auto finish (const game &p_game) -> const std::vector<uint8_t> &;
+
+private:
+  auto flush_run () -> void;
+
+  std::vector<uint8_t> m_data;
+  std::vector<uint32_t> m_checkpoints;
+  unsigned int m_checkpoint_interval; // 0 if there are no checkpoints
+  uint16_t m_run_bits;
+  uint64_t m_run_length;
+  uint64_t m_steps;
+  bool m_finished;
+};
+
+/**@class replay_player
+ * @brief read back the inputs of a replay
+ */
+class replay_player
+{
+public:
+  replay_player ();
+
+  auto load (const std::vector<uint8_t> &data) -> bool;
+  auto next (game_input &input) -> bool;
+  auto check (const game &p_game) -> bool;
+  auto matches (const game &p_game) const -> bool;
+
+  auto
+  get_seed () const
+  {
+    return m_seed;
+  }
+  auto
+  get_steps () const
+  {
+    return m_steps;
+  }
+  auto
+  get_checkpoint_interval () const
+  {
+    return m_checkpoint_interval;
+  }
+  // first step whose checkpoint differed, 0 while the game matches
+  auto
+  get_divergent_step () const
+  {
+    return m_divergent_step;
+  }
+
+private:
+  std::vector<uint8_t> m_runs; // (input bits, run length) pairs
+  std::vector<uint32_t> m_checkpoints;
+  unsigned int m_checkpoint_interval;
+  uint64_t m_played;
+  uint64_t m_divergent_step;
+  std::size_t m_offset;
+  uint16_t m_run_bits;
+  uint64_t m_run_left;
+  uint64_t m_seed;
+  uint64_t m_steps;
+  uint64_t m_checksum;
+};
+
+auto simulate_replay (const std::vector<uint8_t> &data, game &p_game,
+                      uint64_t *p_divergent_step = nullptr) -> bool;
+auto read_replay_file (const char *path, std::vector<uint8_t> &data) -> bool;
+auto write_replay_file (const char *path, const std::vector<uint8_t> &data)
+    -> bool;
+
+#endif /* REPLAY_H */
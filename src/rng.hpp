@@ -0,0 +1,120 @@
+/**@file rng.hpp
+ * @brief contains the pseudo random number generator of the game
+ *
+ * The generator is seeded once per game and produces the same sequence on
+ * every platform (unlike the std:: distributions and std::shuffle, whose
+ * output differs between standard libraries), so games can be replayed.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/**@brief mix a 64 bit value (splitmix64)
+ *
+ * Used to derive well spread seeds and hashes from arbitrary values.
+ * @param value to be mixed, updated to the next value of the sequence
+ * @return mixed value
+ */
+inline auto
+splitmix64 (uint64_t &value) -> uint64_t
+{
+  auto z = (value += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/**@brief mix the bits of a 64 bit value (MurmurHash3 finalizer)
+ *
+ * A bijection with fmix64 (0) == 0, used to turn small keys into hashes.
+ * @param value to be mixed
+ * @return mixed value
+ */
+inline auto
+fmix64 (uint64_t value) -> uint64_t
+{
+  value = (value ^ (value >> 33)) * 0xff51afd7ed558ccdull;
+  value = (value ^ (value >> 33)) * 0xc4ceb9fe1a85ec53ull;
+  return value ^ (value >> 33);
+}
+
+/**@class rng
+ * @brief PCG32 pseudo random number generator
+ */
+class rng
+{
+public:
+  explicit rng (uint64_t seed = 0) { reseed (seed); }
+
+  auto
+  reseed (uint64_t seed) -> void
+  {
+    m_state = 0;
+    m_increment = (splitmix64 (seed) << 1) | 1;
+    next ();
+    m_state += splitmix64 (seed);
+    next ();
+  }
+
+  auto
+  next () -> uint32_t
+  {
+    const auto old_state = m_state;
+    m_state = old_state * 6364136223846793005ull + m_increment;
+    const auto xorshifted
+        = static_cast<uint32_t> (((old_state >> 18) ^ old_state) >> 27);
+    const auto rotation = static_cast<uint32_t> (old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+  }
+
+  /**@brief uniformly distributed number in [0, bound)
+   *
+   * Uses Lemire's multiply and reject method, bound must not be 0.
+   */
+  auto
+  below (uint32_t bound) -> uint32_t
+  {
+    auto product = static_cast<uint64_t> (next ()) * bound;
+    auto low = static_cast<uint32_t> (product);
+    if (low < bound)
+      {
+        const auto threshold = -bound % bound;
+        while (low < threshold)
+          {
+            product = static_cast<uint64_t> (next ()) * bound;
+            low = static_cast<uint32_t> (product);
+          }
+      }
+    return static_cast<uint32_t> (product >> 32);
+  }
+
+  /**@brief shuffle a range in place (Fisher-Yates)
+   */
+  template <typename T>
+  auto
+  shuffle (T *first, T *last) -> void
+  {
+    const auto count = static_cast<uint32_t> (last - first);
+    for (auto i = count; i > 1; --i)
+      {
+        const auto j = below (i);
+        const auto temp = first[i - 1];
+        first[i - 1] = first[j];
+        first[j] = temp;
+      }
+  }
+
+  auto
+  get_state () const
+  {
+    return m_state;
+  }
+
+private:
+  uint64_t m_state;
+  uint64_t m_increment;
+};
+
+#endif /* RNG_H */
@@ -0,0 +1,817 @@
+/** @file sdl_renderer.cpp
+ *  @brief contains implementaion of the SDL render backend
+ *
+ *  Curently we are using SDL2 to render stuff on screen
+ *
+ */
+
+#include "sdl_renderer.hpp"
+#include "trace.hpp"
+/*TODO: location of SDL.h might change depending on the operating system.
+handle that here.  */
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+// helper functions
+
+/**@brief make SDL_Color from rgb values of given color
+ *
+ * @param rgb value of color as 32 bit unsigned integer
+ * @return SDL_Color representing the provided color
+ */
+static auto
+make_sdl_color (uint32_t rgba_color)
+{
+  SDL_Color color;
+  color.r = (unsigned char)((rgba_color >> 24) & 0xff);
+  color.g = (unsigned char)((rgba_color >> 16) & 0xff);
+  color.b = (unsigned char)((rgba_color >> 8) & 0xff);
+  color.a = (unsigned char)((rgba_color >> 0) & 0xff);
+  return color;
+}
+
+/**@brief Print SDL renderer info on stdout
+ *
+ * function simly reads renderer info from provided object of type
+ * SDL_rendererInfo and prints it to stdout.
+ * @param SDL_RendererInfo type object containing renderer's info
+ * @return void
+ */
+static auto
+print_renderer_info (SDL_RendererInfo &rendererInfo)
+{
+  printf ("Renderer: %s software=%d accelerated=%d, presentvsync=%d "
+          "targettexture=%d\n",
+          rendererInfo.name, (rendererInfo.flags & SDL_RENDERER_SOFTWARE) != 0,
+          (rendererInfo.flags & SDL_RENDERER_ACCELERATED) != 0,
+          (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0,
+          (rendererInfo.flags & SDL_RENDERER_TARGETTEXTURE) != 0);
+}
+
+/**@brief hash a C-style string
+ *
+ * FNV-1a, used to look up rendered strings without building a std::string.
+ * @param null terminated string to be hashed
+ * @return hash of the string
+ */
+static auto
+hash_text (const char *text)
+{
+  std::size_t hash = 14695981039346656037ull;
+  for (; *text; ++text)
+    {
+      hash ^= static_cast<unsigned char> (*text);
+      hash *= 1099511628211ull;
+    }
+  return hash;
+}
+
+// class renderer
+
+/**@brief Constructor of sdl_renderer class
+ *
+ * @param object of type SDL_Window on which rendering need to take palce
+ * @param logical width of window
+ * @param logical height of window
+ */
+sdl_renderer::sdl_renderer (SDL_Window &window, unsigned int width,
+                            unsigned int height)
+    : renderer (width, height), m_sdl_renderer (nullptr), m_font (nullptr),
+      m_block_atlas (nullptr), m_text_cache (), m_text_use_count (0),
+      m_text_cache_stats ()
+{
+  Uint32 renderer_flags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+  auto renderer_index = -1;
+  m_sdl_renderer
+      = SDL_CreateRenderer (&window, renderer_index, renderer_flags);
+  if (!m_sdl_renderer)
+    {
+      fprintf (stderr, "SDL_CreateRenderer failed: %s\n", SDL_GetError ());
+      // TODO: terminate the program here;
+    }
+
+  SDL_RendererInfo renderer_info;
+  if (SDL_GetRendererInfo (m_sdl_renderer, &renderer_info) != 0)
+    {
+      fprintf (stderr, "SDL_GetRendererInfo failed: %s\n", SDL_GetError ());
+      // TODO: terminate the program here;
+    }
+  printf ("Created renderer:\n");
+  print_renderer_info (renderer_info);
+
+  int display_width, display_height;
+  SDL_GetWindowSize (&window, &display_width, &display_height);
+  printf ("Display size = (%d, %d)\n", display_width, display_height);
+  printf ("Renderer logical size = (%u, %u)\n", width, height);
+  if (display_width != static_cast<int> (width)
+      || display_height != static_cast<int> (height))
+    {
+      printf ("logical size != display size (%u, %u) vs (%u, %u). Scaling "
+              "will be applied\n",
+              width, height, display_width, display_height);
+    }
+  const auto display_aspect
+      = static_cast<double> (display_width) / display_height;
+  const auto aspect = static_cast<double> (width) / height;
+  if (display_aspect != aspect)
+    {
+      printf (
+          "logical aspect != display aspect. Letterboxing will be applied\n");
+    }
+
+  SDL_RenderSetLogicalSize (m_sdl_renderer, width, height);
+
+  SDL_SetHint (SDL_HINT_RENDER_SCALE_QUALITY,
+               "linear"); // make the scaled rendering look smoother
+
+  if (!build_block_atlas ())
+    {
+      fprintf (stderr, "Failed to build block atlas: %s\n", SDL_GetError ());
+    }
+
+  m_text_cache_stats = {};
+  m_glyph_atlas = {};
+}
+
+/**@brief Print every render driver SDL has, the app calls it once the
+ * first frame is presented
+ *
+ * @return void
+ */
+auto
+sdl_renderer::print_render_drivers () -> void
+{
+  auto num_render_drivers = SDL_GetNumRenderDrivers ();
+  printf ("%d render drivers:\n", num_render_drivers);
+  for (auto i = 0; i < num_render_drivers; ++i)
+    {
+      SDL_RendererInfo renderer_info;
+      SDL_GetRenderDriverInfo (i, &renderer_info);
+      printf ("%d ", i);
+      print_renderer_info (renderer_info);
+    }
+}
+
+/**@brief Open the font text is drawn with, no text is drawn until then
+ *
+ * The font is read from the source while its glyphs are rasterized, a source
+ * in memory must outlive the renderer.
+ *
+ * @param source of the TrueType font, closed by the renderer
+ * @return true if the font was opened, false otherwise
+ */
+auto
+sdl_renderer::load_font (SDL_RWops *source) -> bool
+{
+  TRACE_ZONE ("sdl_renderer::load_font");
+  auto *const font = TTF_OpenFontRW (source, 1, font_size);
+  if (!font)
+    {
+      fprintf (stderr, "TTF_OpenFont failed: %s\n", TTF_GetError ());
+      return false;
+    }
+
+  destroy_text_cache ();
+  SDL_DestroyTexture (m_glyph_atlas.texture);
+  m_glyph_atlas = {};
+  TTF_CloseFont (m_font);
+  m_font = font;
+  if (!build_glyph_atlas (font_size))
+    {
+      fprintf (stderr, "Failed to build glyph atlas: %s\n", SDL_GetError ());
+      return false;
+    }
+  return true;
+}
+
+/**@brief Destructor of sdl_renderer class
+ */
+sdl_renderer::~sdl_renderer ()
+{
+  printf ("Text cache: %lu hits, %lu misses, %lu evictions, %lu textures "
+          "created, %lu strings too long\n",
+          m_text_cache_stats.hits, m_text_cache_stats.misses,
+          m_text_cache_stats.evictions, m_text_cache_stats.textures_created,
+          m_text_cache_stats.uncached);
+  if (m_frame_num)
+    {
+      printf ("Draw calls: %u last frame, %.1f per frame on average\n",
+              m_last_frame_stats.draw_calls,
+              static_cast<double> (m_total_draw_calls) / m_frame_num);
+    }
+  destroy_text_cache ();
+  for (auto &layer : m_layers)
+    SDL_DestroyTexture (layer.texture);
+  SDL_DestroyTexture (m_glyph_atlas.texture);
+  SDL_DestroyTexture (m_block_atlas);
+  TTF_CloseFont (m_font);
+  SDL_DestroyRenderer (m_sdl_renderer);
+}
+
+/**@brief Create the texture holding the block sprites
+ *
+ * The atlas is a row of white square sprites (see block_sprite), blocks are
+ * tinted with vertex colors when drawn.
+ *
+ * @return true if the atlas was created, false otherwise
+ */
+auto
+sdl_renderer::build_block_atlas () -> bool
+{
+  constexpr auto atlas_width = block_sprite_size * block_sprite_num;
+  std::vector<Uint32> pixels (atlas_width * block_sprite_size, 0);
+  for (auto y = 0; y < block_sprite_size; ++y)
+    {
+      for (auto x = 0; x < block_sprite_size; ++x)
+        {
+          const auto on_border = x == 0 || y == 0 || x == block_sprite_size - 1
+                                 || y == block_sprite_size - 1;
+          auto row = &pixels[y * atlas_width];
+          row[static_cast<int> (block_sprite::filled) * block_sprite_size + x]
+              = 0xffffffff;
+          row[static_cast<int> (block_sprite::outline) * block_sprite_size + x]
+              = on_border ? 0xffffffff : 0;
+        }
+    }
+
+  m_block_atlas
+      = SDL_CreateTexture (m_sdl_renderer, SDL_PIXELFORMAT_RGBA32,
+                           SDL_TEXTUREACCESS_STATIC, atlas_width,
+                           block_sprite_size);
+  if (!m_block_atlas)
+    return false;
+  SDL_UpdateTexture (m_block_atlas, nullptr, pixels.data (),
+                     atlas_width * sizeof (Uint32));
+  SDL_SetTextureBlendMode (m_block_atlas, SDL_BLENDMODE_BLEND);
+  // keep the one pixel outlines crisp when blocks are scaled
+  SDL_SetTextureScaleMode (m_block_atlas, SDL_ScaleModeNearest);
+  return true;
+}
+
+/**@brief Rasterize the printable ASCII glyphs of the font into one texture
+ *
+ * Every glyph is rendered once in white, text color is later applied with
+ * texture color modulation. The atlas is laid out as a single row as the
+ * printable range is small.
+ *
+ * @param point size the font was opened with
+ * @return true if the atlas was built, false otherwise
+ */
+auto
+sdl_renderer::build_glyph_atlas (int font_size) -> bool
+{
+  const SDL_Color white = { 255, 255, 255, 255 };
+  SDL_Surface *glyph_surfaces[glyph_atlas::glyph_num] = {};
+
+  auto atlas_width = 0;
+  auto atlas_height = TTF_FontHeight (m_font);
+  for (auto i = 0; i < glyph_atlas::glyph_num; ++i)
+    {
+      const auto glyph = static_cast<Uint16> (glyph_atlas::first_glyph + i);
+      int advance = 0;
+      TTF_GlyphMetrics (m_font, glyph, nullptr, nullptr, nullptr, nullptr,
+                        &advance);
+      m_glyph_atlas.glyph_advance[i] = advance;
+      m_glyph_atlas.glyph_pos[i] = coords (atlas_width, 0);
+      m_glyph_atlas.glyph_width[i] = 0;
+
+      glyph_surfaces[i] = TTF_RenderGlyph_Blended (m_font, glyph, white);
+      if (!glyph_surfaces[i])
+        continue;
+      m_glyph_atlas.glyph_width[i] = glyph_surfaces[i]->w;
+      atlas_width += glyph_surfaces[i]->w;
+      atlas_height = std::max (atlas_height, glyph_surfaces[i]->h);
+    }
+
+  auto atlas_surface = SDL_CreateRGBSurfaceWithFormat (
+      0, std::max (atlas_width, 1), atlas_height, 32, SDL_PIXELFORMAT_RGBA32);
+  if (atlas_surface)
+    {
+      for (auto i = 0; i < glyph_atlas::glyph_num; ++i)
+        {
+          if (!glyph_surfaces[i])
+            continue;
+          SDL_Rect dst_rect = { m_glyph_atlas.glyph_pos[i].x, 0,
+                                glyph_surfaces[i]->w, glyph_surfaces[i]->h };
+          SDL_SetSurfaceBlendMode (glyph_surfaces[i], SDL_BLENDMODE_NONE);
+          SDL_BlitSurface (glyph_surfaces[i], nullptr, atlas_surface,
+                           &dst_rect);
+        }
+      m_glyph_atlas.texture
+          = SDL_CreateTextureFromSurface (m_sdl_renderer, atlas_surface);
+      SDL_FreeSurface (atlas_surface);
+    }
+  for (auto surface : glyph_surfaces)
+    SDL_FreeSurface (surface);
+
+  m_glyph_atlas.font_size = font_size;
+  m_glyph_atlas.line_height = atlas_height;
+  return m_glyph_atlas.texture != nullptr;
+}
+
+/**@brief Destroy every texture held by the rendered text cache
+ */
+auto
+sdl_renderer::destroy_text_cache () -> void
+{
+  for (auto &entry : m_text_cache)
+    {
+      SDL_DestroyTexture (entry.texture);
+      entry = {};
+    }
+}
+
+/**@brief Drop textures whose contents were lost
+ *
+ * Must be called when SDL reports SDL_RENDER_TARGETS_RESET or
+ * SDL_RENDER_DEVICE_RESET, cached strings are re-rendered on next use. Layers
+ * keep their handles (their textures are recreated if needed) but the layer
+ * generation is bumped so that their owners redraw them.
+ *
+ * @param true if every texture was lost (device reset), false if only the
+ * render targets were.
+ * @return void
+ */
+auto
+sdl_renderer::on_render_reset (bool device_lost) -> void
+{
+  destroy_text_cache ();
+  ++m_layer_generation;
+  if (device_lost)
+    {
+      SDL_DestroyTexture (m_block_atlas);
+      m_block_atlas = nullptr;
+      build_block_atlas ();
+
+      for (auto &layer : m_layers)
+        {
+          SDL_DestroyTexture (layer.texture);
+          layer.texture = nullptr;
+          create_layer_texture (layer);
+        }
+    }
+  if (device_lost && m_font)
+    {
+      SDL_DestroyTexture (m_glyph_atlas.texture);
+      m_glyph_atlas.texture = nullptr;
+      build_glyph_atlas (m_glyph_atlas.font_size);
+    }
+}
+
+/**@brief Create (or recreate) the texture backing a layer
+ *
+ * @param layer whose width and height are already set
+ * @return true if the texture was created, false otherwise
+ */
+auto
+sdl_renderer::create_layer_texture (render_layer &layer) -> bool
+{
+  if (!SDL_RenderTargetSupported (m_sdl_renderer))
+    return false;
+
+  layer.texture = SDL_CreateTexture (m_sdl_renderer, SDL_PIXELFORMAT_RGBA32,
+                                     SDL_TEXTUREACCESS_TARGET, layer.width,
+                                     layer.height);
+  if (!layer.texture)
+    return false;
+  SDL_SetTextureBlendMode (layer.texture, SDL_BLENDMODE_BLEND);
+  return true;
+}
+
+/**@brief Create a persistent layer that can be drawn into once and copied to
+ * the screen every frame
+ *
+ * The contents of a layer are lost when the render targets are reset, owners
+ * of a layer should redraw it whenever get_layer_generation () changes.
+ *
+ * @param width of the layer in pixels
+ * @param height of the layer in pixels
+ * @return handle of the layer, -1 if render targets are not supported.
+ */
+auto
+sdl_renderer::create_layer (int width, int height) -> int
+{
+  render_layer layer = { nullptr, width, height };
+  if (!create_layer_texture (layer))
+    return -1;
+  m_layers.push_back (layer);
+  return static_cast<int> (m_layers.size ()) - 1;
+}
+
+/**@brief Redirect drawing into the given layer
+ *
+ * The layer is cleared to transparent, everything drawn until end_layer ()
+ * is called goes to the layer with the layer's top left corner as origin.
+ *
+ * @param handle of the layer
+ * @return true if drawing was redirected, false otherwise
+ */
+auto
+sdl_renderer::begin_layer (int layer) -> bool
+{
+  if (layer < 0 || layer >= static_cast<int> (m_layers.size ())
+      || !m_layers[layer].texture)
+    return false;
+
+  if (SDL_SetRenderTarget (m_sdl_renderer, m_layers[layer].texture) != 0)
+    return false;
+  SDL_SetRenderDrawColor (m_sdl_renderer, 0, 0, 0, 0);
+  SDL_RenderClear (m_sdl_renderer);
+  ++m_frame_stats.draw_calls;
+  return true;
+}
+
+/**@brief Send drawing back to the screen
+ */
+auto
+sdl_renderer::end_layer () -> void
+{
+  SDL_SetRenderTarget (m_sdl_renderer, nullptr);
+}
+
+/**@brief Copy a layer on the screen
+ *
+ * @param handle of the layer
+ * @param location of the top left corner of the layer on the screen
+ * @return void
+ */
+auto
+sdl_renderer::draw_layer (int layer, const coords loc) -> void
+{
+  TRACE_ZONE ("renderer::draw_layer");
+  if (layer < 0 || layer >= static_cast<int> (m_layers.size ())
+      || !m_layers[layer].texture)
+    return;
+
+  const auto &render_layer = m_layers[layer];
+  SDL_Rect dst_rect
+      = { loc.x, loc.y, render_layer.width, render_layer.height };
+  SDL_RenderCopy (m_sdl_renderer, render_layer.texture, nullptr, &dst_rect);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief Build the quads that draw a string from the glyph atlas
+ *
+ * Characters outside of the printable ASCII range are skipped.
+ *
+ * @param null terminated string to be drawn
+ * @param location of the top left corner of the string
+ * @return width and height of the string in pixels
+ */
+auto
+sdl_renderer::build_glyph_quads (const char *text, coords loc) -> coords
+{
+  m_glyph_vertices.clear ();
+  m_glyph_indices.clear ();
+
+  int atlas_width, atlas_height;
+  SDL_QueryTexture (m_glyph_atlas.texture, nullptr, nullptr, &atlas_width,
+                    &atlas_height);
+
+  auto pen_x = loc.x;
+  for (; *text; ++text)
+    {
+      const auto i = static_cast<unsigned char> (*text)
+                     - glyph_atlas::first_glyph;
+      if (i < 0 || i >= glyph_atlas::glyph_num)
+        continue;
+
+      const auto u0 = static_cast<float> (m_glyph_atlas.glyph_pos[i].x)
+                      / atlas_width;
+      const auto u1 = static_cast<float> (m_glyph_atlas.glyph_pos[i].x
+                                          + m_glyph_atlas.glyph_width[i])
+                      / atlas_width;
+      const auto v1 = static_cast<float> (m_glyph_atlas.line_height)
+                      / atlas_height;
+      const auto x0 = static_cast<float> (pen_x);
+      const auto x1 = x0 + m_glyph_atlas.glyph_width[i];
+      const auto y0 = static_cast<float> (loc.y);
+      const auto y1 = y0 + m_glyph_atlas.line_height;
+      const SDL_Color white = { 255, 255, 255, 255 };
+
+      const auto base = static_cast<int> (m_glyph_vertices.size ());
+      m_glyph_vertices.push_back ({ { x0, y0 }, white, { u0, 0.0f } });
+      m_glyph_vertices.push_back ({ { x1, y0 }, white, { u1, 0.0f } });
+      m_glyph_vertices.push_back ({ { x1, y1 }, white, { u1, v1 } });
+      m_glyph_vertices.push_back ({ { x0, y1 }, white, { u0, v1 } });
+      for (auto index : { 0, 1, 2, 0, 2, 3 })
+        m_glyph_indices.push_back (base + index);
+
+      pen_x += m_glyph_atlas.glyph_advance[i];
+    }
+  return coords (pen_x - loc.x, m_glyph_atlas.line_height);
+}
+
+/**@brief Render a string from the glyph atlas into a texture of its own
+ *
+ * The texture is white, color is applied while copying it to the screen.
+ * @param null terminated string to be rendered, at most
+ * max_cached_text_length long
+ * @param cache slot filled with the string, its texture is left null if
+ * render targets are not supported.
+ * @return void
+ */
+auto
+sdl_renderer::render_text_texture (const char *text, cached_text &entry)
+    -> void
+{
+  entry.hash = hash_text (text);
+  std::snprintf (entry.text, sizeof (entry.text), "%s", text);
+  entry.texture = nullptr;
+
+  const auto size = build_glyph_quads (text, coords (0, 0));
+  entry.width = size.x;
+  entry.height = size.y;
+  if (entry.width <= 0 || !SDL_RenderTargetSupported (m_sdl_renderer))
+    return;
+
+  entry.texture = SDL_CreateTexture (m_sdl_renderer, SDL_PIXELFORMAT_RGBA32,
+                                     SDL_TEXTUREACCESS_TARGET, entry.width,
+                                     entry.height);
+  if (!entry.texture)
+    return;
+  ++m_text_cache_stats.textures_created;
+
+  auto previous_target = SDL_GetRenderTarget (m_sdl_renderer);
+  SDL_SetRenderTarget (m_sdl_renderer, entry.texture);
+  SDL_SetRenderDrawColor (m_sdl_renderer, 0, 0, 0, 0);
+  SDL_RenderClear (m_sdl_renderer);
+  // glyphs of the (monospace) font don't overlap, copy them as is
+  SDL_SetTextureBlendMode (m_glyph_atlas.texture, SDL_BLENDMODE_NONE);
+  SDL_SetTextureColorMod (m_glyph_atlas.texture, 255, 255, 255);
+  SDL_SetTextureAlphaMod (m_glyph_atlas.texture, 255);
+  SDL_RenderGeometry (m_sdl_renderer, m_glyph_atlas.texture,
+                      m_glyph_vertices.data (),
+                      static_cast<int> (m_glyph_vertices.size ()),
+                      m_glyph_indices.data (),
+                      static_cast<int> (m_glyph_indices.size ()));
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += m_glyph_indices.size () / 3;
+  SDL_SetRenderTarget (m_sdl_renderer, previous_target);
+
+  SDL_SetTextureBlendMode (entry.texture, SDL_BLENDMODE_BLEND);
+}
+
+/**@brief Draw a string glyph by glyph, without caching it
+ *
+ * @param null terminated string to be drawn
+ * @param location on the screen where text need to be presented.
+ * @param color of the text (rgba)
+ * @return void
+ */
+auto
+sdl_renderer::draw_glyph_quads (const char *text, coords loc,
+                                uint32_t rgba_color) -> void
+{
+  const auto color = make_sdl_color (rgba_color);
+  build_glyph_quads (text, loc);
+  SDL_SetTextureBlendMode (m_glyph_atlas.texture, SDL_BLENDMODE_BLEND);
+  SDL_SetTextureColorMod (m_glyph_atlas.texture, color.r, color.g, color.b);
+  SDL_SetTextureAlphaMod (m_glyph_atlas.texture, color.a);
+  SDL_RenderGeometry (m_sdl_renderer, m_glyph_atlas.texture,
+                      m_glyph_vertices.data (),
+                      static_cast<int> (m_glyph_vertices.size ()),
+                      m_glyph_indices.data (),
+                      static_cast<int> (m_glyph_indices.size ()));
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += m_glyph_indices.size () / 3;
+}
+
+/**@brief Clear the rendering surface
+ *
+ * Paints the entire window with black color.
+ */
+auto
+sdl_renderer::clear () -> void
+{
+  SDL_SetRenderDrawColor (m_sdl_renderer, 0, 0, 0, 255);
+  SDL_RenderClear (m_sdl_renderer);
+  ++m_frame_stats.draw_calls;
+}
+
+/**@brief Update the screen with rendering info
+ */
+auto
+sdl_renderer::present () -> void
+{
+  {
+    TRACE_ZONE ("SDL_RenderPresent");
+    SDL_RenderPresent (m_sdl_renderer);
+  }
+  end_frame_stats ();
+}
+
+/**@brief create an empty rectangle on the screen.
+ *
+ * Draw an empty rentange with the given dimentions on the given location the
+ * window.
+ *
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgb)
+ * @return void
+ */
+auto
+sdl_renderer::draw_rectangle (const coords loc, const int width,
+                              const int height, const uint32_t rgba_color)
+    -> void
+{
+  TRACE_ZONE ("renderer::draw_rectangle");
+  auto color = make_sdl_color (rgba_color);
+  SDL_SetRenderDrawColor (m_sdl_renderer, color.r, color.g, color.b, color.a);
+  SDL_Rect rect = { loc.x, loc.y, width, height };
+  SDL_RenderDrawRect (m_sdl_renderer, &rect);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief create an filled rectangle on the screen.
+ *
+ * Draw an filled rentange with the given dimentions on the given location the
+ * window.
+ *
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgb)
+ * @return void
+ */
+auto
+sdl_renderer::draw_filled_rectangle (const coords loc, const int width,
+                                     const int height,
+                                     const uint32_t rgba_color) -> void
+{
+  TRACE_ZONE ("renderer::draw_filled_rectangle");
+  auto color = make_sdl_color (rgba_color);
+  SDL_SetRenderDrawColor (m_sdl_renderer, color.r, color.g, color.b, color.a);
+
+  SDL_Rect rect = { loc.x, loc.y, width, height };
+  SDL_RenderFillRect (m_sdl_renderer, &rect);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief draw a batch of filled rectangles
+ *
+ * Consecutive rectangles sharing the same color are submitted with a single
+ * SDL_RenderFillRects call, the order of the rectangles is preserved.
+ *
+ * @param pointer to the first rectangle of the batch
+ * @param number of rectangles in the batch
+ * @return void
+ */
+auto
+sdl_renderer::draw_filled_rectangles (const colored_rect *rects,
+                                      std::size_t count) -> void
+{
+  TRACE_ZONE ("renderer::draw_filled_rectangles");
+  for (auto run_begin = 0u; run_begin < count;)
+    {
+      const auto rgba_color = rects[run_begin].rgba_color;
+      m_rect_batch.clear ();
+      auto run_end = run_begin;
+      for (; run_end < count && rects[run_end].rgba_color == rgba_color;
+           ++run_end)
+        {
+          const auto &rect = rects[run_end];
+          m_rect_batch.push_back (
+              { rect.loc.x, rect.loc.y, rect.width, rect.height });
+        }
+
+      auto color = make_sdl_color (rgba_color);
+      SDL_SetRenderDrawColor (m_sdl_renderer, color.r, color.g, color.b,
+                              color.a);
+      SDL_RenderFillRects (m_sdl_renderer, m_rect_batch.data (),
+                           static_cast<int> (m_rect_batch.size ()));
+      ++m_frame_stats.draw_calls;
+      m_frame_stats.primitives += m_rect_batch.size ();
+      run_begin = run_end;
+    }
+}
+
+/**@brief draw a batch of blocks sampled from the block atlas
+ *
+ * The whole batch is submitted as one SDL_RenderGeometry call, blocks are
+ * drawn in the order they are given.
+ *
+ * @param pointer to the first block of the batch
+ * @param number of blocks in the batch
+ * @return void
+ */
+auto
+sdl_renderer::draw_blocks (const block_quad *blocks, std::size_t count) -> void
+{
+  TRACE_ZONE ("renderer::draw_blocks");
+  if (!count || !m_block_atlas)
+    return;
+
+  m_block_vertices.clear ();
+  m_block_indices.clear ();
+  for (auto i = 0u; i < count; ++i)
+    {
+      const auto &block = blocks[i];
+      const auto sprite = static_cast<int> (block.sprite);
+      const auto u0 = static_cast<float> (sprite) / block_sprite_num;
+      const auto u1 = static_cast<float> (sprite + 1) / block_sprite_num;
+      const auto x0 = static_cast<float> (block.loc.x);
+      const auto y0 = static_cast<float> (block.loc.y);
+      const auto x1 = x0 + block.size;
+      const auto y1 = y0 + block.size;
+      const auto color = make_sdl_color (block.rgba_color);
+
+      const auto base = static_cast<int> (m_block_vertices.size ());
+      m_block_vertices.push_back ({ { x0, y0 }, color, { u0, 0.0f } });
+      m_block_vertices.push_back ({ { x1, y0 }, color, { u1, 0.0f } });
+      m_block_vertices.push_back ({ { x1, y1 }, color, { u1, 1.0f } });
+      m_block_vertices.push_back ({ { x0, y1 }, color, { u0, 1.0f } });
+      for (auto index : { 0, 1, 2, 0, 2, 3 })
+        m_block_indices.push_back (base + index);
+    }
+
+  SDL_RenderGeometry (m_sdl_renderer, m_block_atlas, m_block_vertices.data (),
+                      static_cast<int> (m_block_vertices.size ()),
+                      m_block_indices.data (),
+                      static_cast<int> (m_block_indices.size ()));
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += count;
+}
+
+/**@brief Draw text on scren
+ *
+ * Works for C-Style strings
+ *
+ * @param string (const char*) contining the text that needs to be rendered.
+ * @param location on the screen where text need to be presented.
+ * @param color of the text (rgb)
+ * @return void
+ */
+auto
+sdl_renderer::draw_text (const char *text, const coords loc,
+                         const uint32_t rgba_color) -> void
+{
+  TRACE_ZONE ("renderer::draw_text");
+  SDL_assert (text);
+
+  if (!m_glyph_atlas.texture)
+    return;
+
+  if (std::strlen (text) > max_cached_text_length)
+    {
+      ++m_text_cache_stats.uncached;
+      draw_glyph_quads (text, loc, rgba_color);
+      return;
+    }
+
+  // look up the string in the cache, remembering the least recently used
+  // slot (free slots first) in case it isn't there
+  const auto hash = hash_text (text);
+  cached_text *entry = nullptr;
+  auto *victim = &m_text_cache[0];
+  for (auto &slot : m_text_cache)
+    {
+      if (slot.texture && slot.hash == hash && !std::strcmp (slot.text, text))
+        {
+          entry = &slot;
+          break;
+        }
+      if (slot.last_used < victim->last_used)
+        victim = &slot;
+    }
+
+  if (entry)
+    ++m_text_cache_stats.hits;
+  else
+    {
+      ++m_text_cache_stats.misses;
+      if (victim->texture)
+        {
+          ++m_text_cache_stats.evictions;
+          SDL_DestroyTexture (victim->texture);
+          *victim = {};
+        }
+
+      render_text_texture (text, *victim);
+      if (!victim->texture)
+        {
+          // no render target support, draw the quads straight to the screen
+          draw_glyph_quads (text, loc, rgba_color);
+          return;
+        }
+      entry = victim;
+    }
+  entry->last_used = ++m_text_use_count;
+
+  const auto color = make_sdl_color (rgba_color);
+  SDL_SetTextureColorMod (entry->texture, color.r, color.g, color.b);
+  SDL_SetTextureAlphaMod (entry->texture, color.a);
+  SDL_Rect dst_rect = { loc.x, loc.y, entry->width, entry->height };
+  SDL_RenderCopy (m_sdl_renderer, entry->texture, nullptr, &dst_rect);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
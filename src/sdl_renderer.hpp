@@ -0,0 +1,153 @@
+/**@file sdl_renderer.hpp
+ * @brief contains function prototypes for the SDL render backend
+ *
+ * Draws on a window with SDL_Renderer: blocks and glyphs are sampled from
+ * atlas textures, strings are cached in textures of their own and layers are
+ * render target textures.
+ */
+
+#ifndef SDL_RENDERER_H
+#define SDL_RENDERER_H
+
+#include "renderer.hpp"
+#include <SDL2/SDL_ttf.h>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Renderer;
+struct SDL_Texture;
+struct SDL_Vertex;
+
+/**@brief counters of the rendered text cache
+ *
+ * In steady state (text on screen not changing) every draw_text call should
+ * be a hit and textures_created should stay constant.
+ */
+struct text_cache_stats
+{
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  unsigned long textures_created;
+  unsigned long uncached; // too long to be cached, neither hits nor misses
+};
+
+/**@class sdl_renderer
+ * @brief wrapper around SDL renderer tailerd for this application.
+ *
+ */
+class sdl_renderer : public renderer
+{
+public:
+  sdl_renderer (SDL_Window &window, unsigned int width, unsigned int height);
+  ~sdl_renderer () override;
+
+  auto clear () -> void override;
+  auto present () -> void override;
+
+  auto draw_rectangle (const coords loc, const int width, const int height,
+                       const uint32_t rgba_color) -> void override;
+  auto draw_filled_rectangle (const coords loc, const int width,
+                              const int height, const uint32_t rgba_color)
+      -> void override;
+  auto draw_filled_rectangles (const colored_rect *rects, std::size_t count)
+      -> void override;
+  auto draw_blocks (const block_quad *blocks, std::size_t count)
+      -> void override;
+  using renderer::draw_text;
+  auto draw_text (const char *text, const coords loc,
+                  const uint32_t rgba_color) -> void override;
+
+  auto create_layer (int width, int height) -> int override;
+  auto begin_layer (int layer) -> bool override;
+  auto end_layer () -> void override;
+  auto draw_layer (int layer, const coords loc) -> void override;
+
+  auto on_render_reset (bool device_lost) -> void override;
+  auto load_font (SDL_RWops *source) -> bool;
+  static auto print_render_drivers () -> void;
+  auto
+  get_text_cache_stats () const
+  {
+    return m_text_cache_stats;
+  }
+
+private:
+  /**@brief all printable ASCII glyphs of one font size packed in a texture
+   */
+  struct glyph_atlas
+  {
+    static constexpr auto first_glyph = 32;
+    static constexpr auto last_glyph = 126;
+    static constexpr auto glyph_num = last_glyph - first_glyph + 1;
+
+    SDL_Texture *texture;
+    int font_size;
+    int line_height;
+    coords glyph_pos[glyph_num];
+    int glyph_width[glyph_num];
+    int glyph_advance[glyph_num];
+  };
+
+  // long enough for the lines of the frame overlay (see app.cpp)
+  static constexpr auto max_cached_text_length = 95u;
+
+  /**@brief a string that has already been rendered to its own texture
+   *
+   * Slots are stored inline so that replacing a string never allocates.
+   */
+  struct cached_text
+  {
+    std::size_t hash;
+    char text[max_cached_text_length + 1];
+    SDL_Texture *texture; // null if the slot is free
+    int width;
+    int height;
+    unsigned long last_used; // m_text_use_count when it was last drawn
+  };
+
+  /**@brief persistent render target texture
+   */
+  struct render_layer
+  {
+    SDL_Texture *texture;
+    int width;
+    int height;
+  };
+
+  static constexpr auto font_size = 32;
+  static constexpr auto text_cache_capacity = 64u;
+  static constexpr auto block_sprite_size = 32;
+  static constexpr auto block_sprite_num = 2;
+
+  auto build_block_atlas () -> bool;
+  auto create_layer_texture (render_layer &layer) -> bool;
+  auto build_glyph_atlas (int font_size) -> bool;
+  auto destroy_text_cache () -> void;
+  auto render_text_texture (const char *text, cached_text &entry) -> void;
+  auto build_glyph_quads (const char *text, coords loc) -> coords;
+  auto draw_glyph_quads (const char *text, coords loc, uint32_t rgba_color)
+      -> void;
+
+  SDL_Renderer *m_sdl_renderer;
+
+  TTF_Font *m_font;
+
+  SDL_Texture *m_block_atlas;
+  std::vector<SDL_Vertex> m_block_vertices;
+  std::vector<int> m_block_indices;
+  std::vector<SDL_Rect> m_rect_batch;
+
+  std::vector<render_layer> m_layers;
+
+  glyph_atlas m_glyph_atlas;
+  std::vector<SDL_Vertex> m_glyph_vertices;
+  std::vector<int> m_glyph_indices;
+
+  // searched linearly, the least recently used slot is replaced on a miss
+  cached_text m_text_cache[text_cache_capacity];
+  unsigned long m_text_use_count;
+  text_cache_stats m_text_cache_stats;
+};
+
+#endif /* SDL_RENDERER_H */
@@ -0,0 +1,332 @@
+/** @file selfplay.cpp
+ *  @brief headless batch runner playing the game with a placement policy
+ *
+ *  Plays many independent seeded games on every core (see work_pool.hpp),
+ *  each one driven by a placement policy through the rules of the game
+ *  (7-bag randomizer, line clears and top outs included), and reports lines
+ *  cleared, pieces placed, top out rate and games per second. With --tune,
+ *  an evolution strategy searches for better policy weights instead.
+ *
+ *  --games N          number of games played (1000)
+ *  --threads N        number of threads, 0 for every core (0)
+ *  --seed N           seed of the first game, game i uses seed + i (1)
+ *  --pieces N         pieces after which a game is stopped (1000)
+ *  --weights A,B,C,D  weights of lines cleared, aggregate height, holes and
+ *                     bumpiness (see policy.hpp)
+ *  --tune N           tune the weights for N generations
+ *  --population N     candidates per generation when tuning (16)
+ *  --tune-games N     games played by every candidate (32)
+ */
+
+#include "game.hpp"
+#include "policy.hpp"
+#include "rng.hpp"
+#include "work_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/** @brief totals over a number of games
+ */
+struct game_stats
+{
+  unsigned long games;
+  unsigned long topouts;
+  unsigned long pieces;
+  unsigned long lines;
+
+  auto
+  add (const game_stats &other) -> void
+  {
+    games += other.games;
+    topouts += other.topouts;
+    pieces += other.pieces;
+    lines += other.lines;
+  }
+};
+
+struct selfplay_options
+{
+  unsigned long games;
+  unsigned int threads;
+  uint64_t seed;
+  unsigned int max_pieces;
+  policy_weights weights;
+  unsigned int generations;
+  unsigned int population;
+  unsigned int tune_games;
+};
+
+/** @brief Play a game until it is over or max_pieces are placed
+ *
+ *  @param seed of the game
+ *  @param weights of the policy placing the pieces
+ *  @param pieces after which the game is stopped
+ *  @param totals the game is added to
+ *  @return void
+ */
+static void
+play_game (uint64_t seed, const policy_weights &weights,
+           unsigned int max_pieces, game_stats &stats)
+{
+  game played_game (seed);
+  game_input start_input = {};
+  start_input.m_start = true;
+  played_game.step (start_input);
+
+  placement_policy policy (weights);
+  auto pieces = 0u;
+  while (pieces < max_pieces)
+    {
+      const auto view = played_game.view ();
+      if (view.m_state != game_state::playing)
+        break;
+
+      placement choice;
+      if (!policy.choose (*view.m_board, view.m_active_tetromino, choice))
+        break;
+      const auto result = played_game.place_tetromino (choice.m_landing);
+      stats.lines += result.lines.count;
+      ++pieces;
+    }
+
+  ++stats.games;
+  stats.pieces += pieces;
+  if (played_game.view ().m_state == game_state::game_over)
+    ++stats.topouts;
+}
+
+/** @brief Play a batch of games with the same weights on every worker
+ *
+ *  @return totals over the games
+ */
+static game_stats
+run_batch (work_pool &pool, const selfplay_options &options)
+{
+  std::vector<game_stats> worker_stats (pool.get_thread_num (), game_stats{});
+  pool.run (options.games, [&] (std::size_t task, unsigned int worker) {
+    play_game (options.seed + task, options.weights, options.max_pieces,
+               worker_stats[worker]);
+  });
+
+  game_stats total = {};
+  for (const auto &stats : worker_stats)
+    total.add (stats);
+  return total;
+}
+
+/** @brief Print the totals of a batch
+ */
+static void
+print_stats (const game_stats &stats, double seconds)
+{
+  const auto games = static_cast<double> (std::max (stats.games, 1ul));
+  printf ("%lu games in %.2f s (%.1f games/s, %.0f pieces/s)\n", stats.games,
+          seconds, stats.games / seconds, stats.pieces / seconds);
+  printf ("lines/game %.1f, pieces/game %.1f, top out rate %.1f%%\n",
+          stats.lines / games, stats.pieces / games,
+          100.0 * stats.topouts / games);
+}
+
+/** @brief Print weights the way --weights takes them, followed by a newline
+ */
+static void
+print_weights (const policy_weights &weights)
+{
+  for (auto f = 0; f < policy_weights::feature_num; ++f)
+    printf ("%s%.4f", f ? "," : "", weights.values[f]);
+  printf ("\n");
+}
+
+/** @brief Draw a number from the standard normal distribution (Box-Muller)
+ */
+static float
+normal_sample (rng &p_rng)
+{
+  const auto u1 = (p_rng.next () + 1.0) / 4294967297.0; // in (0, 1)
+  const auto u2 = p_rng.next () / 4294967296.0;
+  return static_cast<float> (std::sqrt (-2.0 * std::log (u1))
+                             * std::cos (6.283185307179586 * u2));
+}
+
+/** @brief Tune the policy weights with a (mu, lambda) evolution strategy
+ *
+ *  Every generation samples candidates around the current mean (the mean
+ *  itself being the first candidate), plays tune_games games with each of
+ *  them on the same seeds and moves the mean to the average of the best
+ *  quarter. Candidates are scored by the lines cleared per game, so a
+ *  candidate that survives to max_pieces beats one that tops out early.
+ *
+ *  @return the best weights found
+ */
+static policy_weights
+tune_weights (work_pool &pool, const selfplay_options &options)
+{
+  constexpr auto feature_num = policy_weights::feature_num;
+  const auto population = std::max (options.population, 2u);
+  const auto elite_num = std::max (population / 4, 1u);
+  rng tuning_rng (options.seed);
+
+  auto mean = options.weights;
+  auto best = mean;
+  auto best_lines = -1.0;
+  auto sigma = 0.25f;
+
+  std::vector<policy_weights> candidates (population);
+  std::vector<game_stats> stats (population * pool.get_thread_num ());
+  std::vector<std::pair<double, unsigned int>> ranking (population);
+  for (auto generation = 0u; generation < options.generations; ++generation)
+    {
+      const auto start = std::chrono::steady_clock::now ();
+      for (auto i = 0u; i < population; ++i)
+        {
+          candidates[i] = mean;
+          for (auto f = 0; f < feature_num && i > 0; ++f)
+            candidates[i].values[f] += sigma * normal_sample (tuning_rng);
+        }
+
+      std::fill (stats.begin (), stats.end (), game_stats{});
+      pool.run (static_cast<std::size_t> (population) * options.tune_games,
+                [&] (std::size_t task, unsigned int worker) {
+                  const auto candidate = task / options.tune_games;
+                  const auto game = task % options.tune_games;
+                  play_game (options.seed + game, candidates[candidate],
+                             options.max_pieces,
+                             stats[worker * population + candidate]);
+                });
+
+      for (auto i = 0u; i < population; ++i)
+        {
+          game_stats total = {};
+          for (auto worker = 0u; worker < pool.get_thread_num (); ++worker)
+            total.add (stats[worker * population + i]);
+          ranking[i] = { static_cast<double> (total.lines) / total.games, i };
+        }
+      const auto mean_lines = ranking[0].first; // candidate 0 is the mean
+      std::sort (ranking.begin (), ranking.end (),
+                 [] (const std::pair<double, unsigned int> &a,
+                     const std::pair<double, unsigned int> &b) {
+                   return a.first > b.first;
+                 });
+
+      if (ranking[0].first > best_lines)
+        {
+          best_lines = ranking[0].first;
+          best = candidates[ranking[0].second];
+        }
+
+      policy_weights next_mean = {};
+      for (auto i = 0u; i < elite_num; ++i)
+        for (auto f = 0; f < feature_num; ++f)
+          next_mean.values[f]
+              += candidates[ranking[i].second].values[f] / elite_num;
+      mean = next_mean;
+      sigma *= 0.95f;
+
+      const auto seconds = std::chrono::duration<double> (
+                               std::chrono::steady_clock::now () - start)
+                               .count ();
+      printf ("generation %u: best %.1f lines/game, mean %.1f (%.1f s), best "
+              "weights ",
+              generation, ranking[0].first, mean_lines, seconds);
+      print_weights (best);
+      fflush (stdout);
+    }
+  return best;
+}
+
+/** @brief Parse comma separated weights
+ *
+ *  @return false if there aren't exactly policy_weights::feature_num numbers
+ */
+static bool
+parse_weights (const char *text, policy_weights &weights)
+{
+  for (auto f = 0; f < policy_weights::feature_num; ++f)
+    {
+      char *end;
+      weights.values[f] = strtof (text, &end);
+      if (end == text)
+        return false;
+      const auto last = f + 1 == policy_weights::feature_num;
+      if ((last && *end) || (!last && *end != ','))
+        return false;
+      text = end + 1;
+    }
+  return true;
+}
+
+/** @brief Parse the command line
+ *
+ *  @return false if the command line is invalid
+ */
+static bool
+parse_options (int argc, char *argv[], selfplay_options &options)
+{
+  for (int i = 1; i < argc; ++i)
+    {
+      const bool has_value = i + 1 < argc;
+      if (!strcmp (argv[i], "--games") && has_value)
+        options.games = strtoul (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--threads") && has_value)
+        options.threads = strtoul (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--seed") && has_value)
+        options.seed = strtoull (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--pieces") && has_value)
+        options.max_pieces = strtoul (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--weights") && has_value)
+        {
+          if (!parse_weights (argv[++i], options.weights))
+            {
+              fprintf (stderr, "Invalid weights %s\n", argv[i]);
+              return false;
+            }
+        }
+      else if (!strcmp (argv[i], "--tune") && has_value)
+        options.generations = strtoul (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--population") && has_value)
+        options.population = strtoul (argv[++i], nullptr, 0);
+      else if (!strcmp (argv[i], "--tune-games") && has_value)
+        options.tune_games = strtoul (argv[++i], nullptr, 0);
+      else
+        {
+          fprintf (stderr, "Unknown option %s\n", argv[i]);
+          return false;
+        }
+    }
+  return options.tune_games > 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  selfplay_options options = {};
+  options.games = 1000;
+  options.seed = 1;
+  options.max_pieces = 1000;
+  options.weights = get_default_policy_weights ();
+  options.population = 16;
+  options.tune_games = 32;
+  if (!parse_options (argc, argv, options))
+    return 1;
+
+  work_pool pool (options.threads);
+  printf ("%u threads\n", pool.get_thread_num ());
+  if (options.generations)
+    {
+      options.weights = tune_weights (pool, options);
+      printf ("tuned weights ");
+      print_weights (options.weights);
+    }
+
+  const auto start = std::chrono::steady_clock::now ();
+  const auto stats = run_batch (pool, options);
+  print_stats (stats, std::chrono::duration<double> (
+                          std::chrono::steady_clock::now () - start)
+                          .count ());
+  return 0;
+}
@@ -0,0 +1,576 @@
+/**@file software_renderer.cpp
+ * @brief contains implementaion of the software render backend
+ *
+ * Blending follows SDL_BLENDMODE_BLEND so that both backends produce the
+ * same image: dst = src * a + dst * (1 - a) for the colors and
+ * dst = a + dst * (1 - a) for the alpha, rounded to the nearest integer.
+ */
+
+#include "software_renderer.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+/**@brief printable ASCII glyphs (32 to 126) of a 5x7 font
+ *
+ * One byte per column, bit 0 is the top row.
+ */
+constexpr unsigned char font_5x7[][5] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 },
+  { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7f, 0x14, 0x7f, 0x14 },
+  { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+  { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+  { 0x00, 0x1c, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1c, 0x00 },
+  { 0x14, 0x08, 0x3e, 0x08, 0x14 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+  { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 },
+  { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+  { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 },
+  { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 },
+  { 0x18, 0x14, 0x12, 0x7f, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 },
+  { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e },
+  { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+  { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+  { 0x32, 0x49, 0x79, 0x41, 0x3e }, { 0x7e, 0x11, 0x11, 0x11, 0x7e },
+  { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+  { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 },
+  { 0x7f, 0x09, 0x09, 0x09, 0x01 }, { 0x3e, 0x41, 0x49, 0x49, 0x7a },
+  { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 },
+  { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 },
+  { 0x7f, 0x40, 0x40, 0x40, 0x40 }, { 0x7f, 0x02, 0x0c, 0x02, 0x7f },
+  { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+  { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e },
+  { 0x7f, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+  { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f },
+  { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f },
+  { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 },
+  { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 },
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 },
+  { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+  { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+  { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+  { 0x38, 0x44, 0x44, 0x48, 0x7f }, { 0x38, 0x54, 0x54, 0x54, 0x18 },
+  { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x0c, 0x52, 0x52, 0x52, 0x3e },
+  { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 },
+  { 0x20, 0x40, 0x44, 0x3d, 0x00 }, { 0x7f, 0x10, 0x28, 0x44, 0x00 },
+  { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 },
+  { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+  { 0x7c, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7c },
+  { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+  { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c },
+  { 0x1c, 0x20, 0x40, 0x20, 0x1c }, { 0x3c, 0x40, 0x30, 0x40, 0x3c },
+  { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c },
+  { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+  { 0x00, 0x00, 0x7f, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 },
+  { 0x02, 0x01, 0x02, 0x04, 0x02 },
+};
+
+constexpr auto first_glyph = 32;
+constexpr auto last_glyph = 126;
+constexpr auto glyph_columns = 5;
+constexpr auto glyph_rows = 7;
+
+/**@brief convert a 0xRRGGBBAA color to a framebuffer pixel
+ */
+inline auto
+to_pixel (uint32_t rgba_color) -> uint32_t
+{
+  const unsigned char bytes[4]
+      = { static_cast<unsigned char> (rgba_color >> 24),
+          static_cast<unsigned char> (rgba_color >> 16),
+          static_cast<unsigned char> (rgba_color >> 8),
+          static_cast<unsigned char> (rgba_color) };
+  uint32_t pixel;
+  std::memcpy (&pixel, bytes, sizeof (pixel));
+  return pixel;
+}
+
+/**@brief value / 255 rounded to the nearest integer, value <= 255 * 255
+ */
+inline auto
+div_255 (unsigned int value) -> unsigned int
+{
+  value += 128;
+  return (value + (value >> 8)) >> 8;
+}
+
+/**@brief set n pixels to the same value
+ */
+auto
+fill_span (uint32_t *dst, int n, uint32_t pixel) -> void
+{
+  auto i = 0;
+#ifdef __SSE2__
+  const auto value = _mm_set1_epi32 (static_cast<int> (pixel));
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_si128 (reinterpret_cast<__m128i *> (dst + i), value);
+#endif
+  for (; i < n; ++i)
+    dst[i] = pixel;
+}
+
+/**@brief blend the same pixel over n pixels
+ */
+auto
+blend_span (uint32_t *dst, int n, uint32_t pixel) -> void
+{
+  unsigned char src[4];
+  std::memcpy (src, &pixel, sizeof (src));
+  const unsigned int alpha = src[3];
+  if (alpha == 255)
+    {
+      fill_span (dst, n, pixel);
+      return;
+    }
+  if (!alpha)
+    return;
+
+  // the source alpha counts as 255 in the alpha channel
+  const unsigned int scaled[4] = { src[0] * alpha, src[1] * alpha,
+                                   src[2] * alpha, 255 * alpha };
+  const auto inverse = 255 - alpha;
+  auto i = 0;
+#ifdef __SSE2__
+  const auto zero = _mm_setzero_si128 ();
+  const auto inverse16 = _mm_set1_epi16 (static_cast<short> (inverse));
+  short rounded[8]; // two unpacked pixels
+  for (auto c = 0; c < 8; ++c)
+    rounded[c] = static_cast<short> (scaled[c % 4] + 128);
+  const auto scaled16
+      = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (rounded));
+  auto blend_half = [&] (__m128i half) {
+    half = _mm_add_epi16 (_mm_mullo_epi16 (half, inverse16), scaled16);
+    return _mm_srli_epi16 (_mm_add_epi16 (half, _mm_srli_epi16 (half, 8)), 8);
+  };
+  for (; i + 4 <= n; i += 4)
+    {
+      auto *p = reinterpret_cast<__m128i *> (dst + i);
+      const auto pixels = _mm_loadu_si128 (p);
+      const auto low = blend_half (_mm_unpacklo_epi8 (pixels, zero));
+      const auto high = blend_half (_mm_unpackhi_epi8 (pixels, zero));
+      _mm_storeu_si128 (p, _mm_packus_epi16 (low, high));
+    }
+#endif
+  for (; i < n; ++i)
+    {
+      auto *bytes = reinterpret_cast<unsigned char *> (dst + i);
+      for (auto c = 0; c < 4; ++c)
+        bytes[c] = static_cast<unsigned char> (
+            div_255 (scaled[c] + bytes[c] * inverse));
+    }
+}
+
+/**@brief blend n pixels, each with its own alpha, over n pixels
+ */
+auto
+blend_pixels (uint32_t *dst, const uint32_t *src, int n) -> void
+{
+  auto i = 0;
+#ifdef __SSE2__
+  const auto zero = _mm_setzero_si128 ();
+  const auto alpha_mask = _mm_set1_epi32 (static_cast<int> (to_pixel (0xff)));
+  const auto max16 = _mm_set1_epi16 (255);
+  const auto round16 = _mm_set1_epi16 (128);
+  // alpha lanes of two unpacked pixels
+  const auto alpha16 = _mm_set_epi16 (255, 0, 0, 0, 255, 0, 0, 0);
+  auto blend_half = [&] (__m128i src_half, __m128i dst_half) {
+    auto alpha = _mm_shufflelo_epi16 (src_half, _MM_SHUFFLE (3, 3, 3, 3));
+    alpha = _mm_shufflehi_epi16 (alpha, _MM_SHUFFLE (3, 3, 3, 3));
+    src_half = _mm_or_si128 (_mm_andnot_si128 (alpha16, src_half), alpha16);
+    auto sum = _mm_add_epi16 (_mm_mullo_epi16 (src_half, alpha),
+                              _mm_mullo_epi16 (dst_half,
+                                               _mm_sub_epi16 (max16, alpha)));
+    sum = _mm_add_epi16 (sum, round16);
+    return _mm_srli_epi16 (_mm_add_epi16 (sum, _mm_srli_epi16 (sum, 8)), 8);
+  };
+  for (; i + 4 <= n; i += 4)
+    {
+      const auto pixels
+          = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (src + i));
+      const auto alpha = _mm_and_si128 (pixels, alpha_mask);
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, zero)) == 0xffff)
+        continue; // fully transparent
+      auto *p = reinterpret_cast<__m128i *> (dst + i);
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, alpha_mask)) == 0xffff)
+        {
+          _mm_storeu_si128 (p, pixels); // fully opaque
+          continue;
+        }
+      const auto under = _mm_loadu_si128 (p);
+      const auto low = blend_half (_mm_unpacklo_epi8 (pixels, zero),
+                                   _mm_unpacklo_epi8 (under, zero));
+      const auto high = blend_half (_mm_unpackhi_epi8 (pixels, zero),
+                                    _mm_unpackhi_epi8 (under, zero));
+      _mm_storeu_si128 (p, _mm_packus_epi16 (low, high));
+    }
+#endif
+  for (; i < n; ++i)
+    {
+      const auto *over = reinterpret_cast<const unsigned char *> (src + i);
+      auto *bytes = reinterpret_cast<unsigned char *> (dst + i);
+      const unsigned int alpha = over[3];
+      for (auto c = 0; c < 4; ++c)
+        {
+          const unsigned int value = c == 3 ? 255 : over[c];
+          bytes[c] = static_cast<unsigned char> (
+              div_255 (value * alpha + bytes[c] * (255 - alpha)));
+        }
+    }
+}
+
+} // namespace
+
+/**@brief Constructor of the software renderer
+ *
+ * @param width of the framebuffer in pixels
+ * @param height of the framebuffer in pixels
+ */
+software_renderer::software_renderer (unsigned int width, unsigned int height)
+    : renderer (width, height), m_target_layer (-1)
+{
+  m_screen.width = static_cast<int> (width);
+  m_screen.height = static_cast<int> (height);
+  m_screen.pixels.assign (width * height, to_pixel (0x000000ff));
+}
+
+/**@brief get the surface drawing currently goes to
+ */
+auto
+software_renderer::get_target () -> surface &
+{
+  return m_target_layer < 0 ? m_screen : m_layers[m_target_layer];
+}
+
+/**@brief fill or blend a rectangle of the target, clipped to its bounds
+ *
+ * @param left column
+ * @param top row
+ * @param width in pixels
+ * @param height in pixels
+ * @param framebuffer pixel (see to_pixel)
+ * @param true to blend the pixel, false to replace the pixels covered
+ * @return void
+ */
+auto
+software_renderer::fill_rect (int x, int y, int width, int height,
+                              uint32_t pixel, bool blend) -> void
+{
+  auto &target = get_target ();
+  const auto x0 = std::max (x, 0);
+  const auto y0 = std::max (y, 0);
+  const auto x1 = std::min (x + width, target.width);
+  const auto y1 = std::min (y + height, target.height);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  auto *row = target.pixels.data () + y0 * target.width + x0;
+  for (auto row_y = y0; row_y < y1; ++row_y, row += target.width)
+    {
+      if (blend)
+        blend_span (row, x1 - x0, pixel);
+      else
+        fill_span (row, x1 - x0, pixel);
+    }
+}
+
+/**@brief Clear the framebuffer to opaque black
+ */
+auto
+software_renderer::clear () -> void
+{
+  TRACE_ZONE ("renderer::clear");
+  fill_span (m_screen.pixels.data (),
+             static_cast<int> (m_screen.pixels.size ()),
+             to_pixel (0x000000ff));
+  ++m_frame_stats.draw_calls;
+}
+
+/**@brief Finish the frame, the framebuffer keeps its contents until the
+ * next clear
+ */
+auto
+software_renderer::present () -> void
+{
+  end_frame_stats ();
+}
+
+/**@brief draw the 1 pixel wide outline of a rectangle
+ *
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgba)
+ * @return void
+ */
+auto
+software_renderer::draw_rectangle (const coords loc, const int width,
+                                   const int height, const uint32_t rgba_color)
+    -> void
+{
+  if (width <= 0 || height <= 0)
+    return;
+  const auto pixel = to_pixel (rgba_color);
+  fill_rect (loc.x, loc.y, width, 1, pixel, false);
+  fill_rect (loc.x, loc.y + height - 1, width, 1, pixel, false);
+  fill_rect (loc.x, loc.y + 1, 1, height - 2, pixel, false);
+  fill_rect (loc.x + width - 1, loc.y + 1, 1, height - 2, pixel, false);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief draw a filled rectangle
+ *
+ * @param location of the rectangle
+ * @param width of the rectangle
+ * @param height of the rectangle
+ * @param color of the rectangle (rgba)
+ * @return void
+ */
+auto
+software_renderer::draw_filled_rectangle (const coords loc, const int width,
+                                          const int height,
+                                          const uint32_t rgba_color) -> void
+{
+  fill_rect (loc.x, loc.y, width, height, to_pixel (rgba_color), false);
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief draw a batch of filled rectangles, in order
+ *
+ * @param pointer to the first rectangle of the batch
+ * @param number of rectangles in the batch
+ * @return void
+ */
+auto
+software_renderer::draw_filled_rectangles (const colored_rect *rects,
+                                           std::size_t count) -> void
+{
+  TRACE_ZONE ("renderer::draw_filled_rectangles");
+  if (!count)
+    return;
+  for (auto i = 0u; i < count; ++i)
+    fill_rect (rects[i].loc.x, rects[i].loc.y, rects[i].width,
+               rects[i].height, to_pixel (rects[i].rgba_color), false);
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += count;
+}
+
+/**@brief draw a batch of blocks, in order
+ *
+ * Filled blocks are solid squares, outlined blocks only their 1 pixel wide
+ * border, both are blended with the alpha of their color.
+ *
+ * @param pointer to the first block of the batch
+ * @param number of blocks in the batch
+ * @return void
+ */
+auto
+software_renderer::draw_blocks (const block_quad *blocks, std::size_t count)
+    -> void
+{
+  TRACE_ZONE ("renderer::draw_blocks");
+  if (!count)
+    return;
+  for (auto i = 0u; i < count; ++i)
+    {
+      const auto &block = blocks[i];
+      const auto pixel = to_pixel (block.rgba_color);
+      if (block.sprite == block_sprite::filled)
+        {
+          fill_rect (block.loc.x, block.loc.y, block.size, block.size, pixel,
+                     true);
+          continue;
+        }
+      const auto x = block.loc.x;
+      const auto y = block.loc.y;
+      fill_rect (x, y, block.size, 1, pixel, true);
+      fill_rect (x, y + block.size - 1, block.size, 1, pixel, true);
+      fill_rect (x, y + 1, 1, block.size - 2, pixel, true);
+      fill_rect (x + block.size - 1, y + 1, 1, block.size - 2, pixel, true);
+    }
+  ++m_frame_stats.draw_calls;
+  m_frame_stats.primitives += count;
+}
+
+/**@brief Draw text with the built in 5x7 font
+ *
+ * Every run of lit pixels of a glyph row is blended as one span, characters
+ * outside of printable ASCII are drawn as '?'.
+ *
+ * @param null terminated string to be drawn
+ * @param location of the top left corner of the text
+ * @param color of the text (rgba)
+ * @return void
+ */
+auto
+software_renderer::draw_text (const char *text, const coords loc,
+                              const uint32_t rgba_color) -> void
+{
+  TRACE_ZONE ("renderer::draw_text");
+  const auto pixel = to_pixel (rgba_color);
+  auto pen_x = loc.x;
+  for (; *text; ++text, pen_x += (glyph_columns + 1) * glyph_scale)
+    {
+      auto c = static_cast<unsigned char> (*text);
+      if (c < first_glyph || c > last_glyph)
+        c = '?';
+      const auto &glyph = font_5x7[c - first_glyph];
+      for (auto row = 0; row < glyph_rows; ++row)
+        {
+          for (auto column = 0; column < glyph_columns;)
+            {
+              if (!(glyph[column] >> row & 1))
+                {
+                  ++column;
+                  continue;
+                }
+              const auto run_start = column;
+              while (column < glyph_columns && glyph[column] >> row & 1)
+                ++column;
+              fill_rect (pen_x + run_start * glyph_scale,
+                         loc.y + row * glyph_scale,
+                         (column - run_start) * glyph_scale, glyph_scale,
+                         pixel, true);
+            }
+        }
+    }
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief Create a persistent layer, a framebuffer of its own
+ *
+ * Layers in memory are never lost, the layer generation never changes.
+ *
+ * @param width of the layer in pixels
+ * @param height of the layer in pixels
+ * @return handle of the layer, -1 if the size is invalid.
+ */
+auto
+software_renderer::create_layer (int width, int height) -> int
+{
+  if (width <= 0 || height <= 0)
+    return -1;
+  surface layer;
+  layer.width = width;
+  layer.height = height;
+  layer.pixels.assign (static_cast<std::size_t> (width) * height, 0);
+  m_layers.push_back (std::move (layer));
+  return static_cast<int> (m_layers.size ()) - 1;
+}
+
+/**@brief Redirect drawing into the given layer, cleared to transparent
+ *
+ * @param handle of the layer
+ * @return true if drawing was redirected, false otherwise
+ */
+auto
+software_renderer::begin_layer (int layer) -> bool
+{
+  if (layer < 0 || layer >= static_cast<int> (m_layers.size ()))
+    return false;
+  m_target_layer = layer;
+  auto &pixels = m_layers[layer].pixels;
+  fill_span (pixels.data (), static_cast<int> (pixels.size ()), 0);
+  ++m_frame_stats.draw_calls;
+  return true;
+}
+
+/**@brief Send drawing back to the screen
+ */
+auto
+software_renderer::end_layer () -> void
+{
+  m_target_layer = -1;
+}
+
+/**@brief Blend a layer on the screen
+ *
+ * @param handle of the layer
+ * @param location of the top left corner of the layer on the screen
+ * @return void
+ */
+auto
+software_renderer::draw_layer (int layer, const coords loc) -> void
+{
+  TRACE_ZONE ("renderer::draw_layer");
+  if (layer < 0 || layer >= static_cast<int> (m_layers.size ()))
+    return;
+
+  const auto &source = m_layers[layer];
+  const auto x0 = std::max (loc.x, 0);
+  const auto y0 = std::max (loc.y, 0);
+  const auto x1 = std::min (loc.x + source.width, m_screen.width);
+  const auto y1 = std::min (loc.y + source.height, m_screen.height);
+  if (x0 < x1 && y0 < y1)
+    {
+      for (auto y = y0; y < y1; ++y)
+        blend_pixels (m_screen.pixels.data () + y * m_screen.width + x0,
+                      source.pixels.data () + (y - loc.y) * source.width
+                          + (x0 - loc.x),
+                      x1 - x0);
+    }
+  ++m_frame_stats.draw_calls;
+  ++m_frame_stats.primitives;
+}
+
+/**@brief get a pixel of the screen
+ *
+ * @param column of the pixel
+ * @param row of the pixel
+ * @return color of the pixel (0xRRGGBBAA)
+ */
+auto
+software_renderer::get_pixel (int x, int y) const -> uint32_t
+{
+  unsigned char bytes[4];
+  std::memcpy (bytes, &m_screen.pixels[y * m_screen.width + x],
+               sizeof (bytes));
+  return uint32_t (bytes[0]) << 24 | uint32_t (bytes[1]) << 16
+         | uint32_t (bytes[2]) << 8 | bytes[3];
+}
+
+/**@brief Save the screen as a binary PPM image, alpha is dropped
+ *
+ * @param path of the image
+ * @return true if the image was written, false otherwise
+ */
+auto
+software_renderer::write_ppm (const char *path) const -> bool
+{
+  auto *file = fopen (path, "wb");
+  if (!file)
+    {
+      fprintf (stderr, "Failed to open %s\n", path);
+      return false;
+    }
+
+  fprintf (file, "P6\n%d %d\n255\n", m_screen.width, m_screen.height);
+  std::vector<unsigned char> row (m_screen.width * 3);
+  auto ok = true;
+  for (auto y = 0; y < m_screen.height && ok; ++y)
+    {
+      const auto *pixels = reinterpret_cast<const unsigned char *> (
+          m_screen.pixels.data () + y * m_screen.width);
+      for (auto x = 0; x < m_screen.width; ++x)
+        std::memcpy (&row[x * 3], pixels + x * 4, 3);
+      ok = fwrite (row.data (), 1, row.size (), file) == row.size ();
+    }
+  if (fclose (file) != 0 || !ok)
+    {
+      fprintf (stderr, "Failed to write %s\n", path);
+      return false;
+    }
+  return true;
+}
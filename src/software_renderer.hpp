@@ -0,0 +1,73 @@
+/**@file software_renderer.hpp
+ * @brief contains a render backend rasterizing on the CPU
+ *
+ * Draws into an RGBA framebuffer in memory, without a window or a GPU, so
+ * the frontend can render on headless machines, be compared against golden
+ * images or render replays offline. Every primitive is a set of horizontal
+ * spans which are filled or blended 4 pixels at a time with SSE2 (with a
+ * scalar fallback on other targets).
+ */
+
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include "renderer.hpp"
+#include <vector>
+
+class software_renderer : public renderer
+{
+public:
+  software_renderer (unsigned int width, unsigned int height);
+
+  auto clear () -> void override;
+  auto present () -> void override;
+
+  auto draw_rectangle (const coords loc, const int width, const int height,
+                       const uint32_t rgba_color) -> void override;
+  auto draw_filled_rectangle (const coords loc, const int width,
+                              const int height, const uint32_t rgba_color)
+      -> void override;
+  auto draw_filled_rectangles (const colored_rect *rects, std::size_t count)
+      -> void override;
+  auto draw_blocks (const block_quad *blocks, std::size_t count)
+      -> void override;
+  using renderer::draw_text;
+  auto draw_text (const char *text, const coords loc,
+                  const uint32_t rgba_color) -> void override;
+
+  auto create_layer (int width, int height) -> int override;
+  auto begin_layer (int layer) -> bool override;
+  auto end_layer () -> void override;
+  auto draw_layer (int layer, const coords loc) -> void override;
+
+  // pixels of the screen, row after row, the bytes of every pixel are R, G,
+  // B and A in memory order
+  auto
+  get_pixels () const
+  {
+    return m_screen.pixels.data ();
+  }
+  auto get_pixel (int x, int y) const -> uint32_t;
+  auto write_ppm (const char *path) const -> bool;
+
+private:
+  struct surface
+  {
+    std::vector<uint32_t> pixels;
+    int width;
+    int height;
+  };
+
+  // the 5x7 font is scaled up to roughly the size of the SDL backend's font
+  static constexpr auto glyph_scale = 3;
+
+  auto get_target () -> surface &;
+  auto fill_rect (int x, int y, int width, int height, uint32_t pixel,
+                  bool blend) -> void;
+
+  surface m_screen;
+  std::vector<surface> m_layers;
+  int m_target_layer; // layer being drawn, -1 for the screen
+};
+
+#endif /* SOFTWARE_RENDERER_H */
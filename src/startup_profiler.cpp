@@ -0,0 +1,157 @@
+/**@file startup_profiler.cpp
+ * @brief contains functions that time the startup of the app.
+ *
+ */
+
+#include "startup_profiler.hpp"
+#include <cstdio>
+
+/**@brief Constructor of startup_profiler class
+ *
+ * The profiler is meant to be a global, constructed before main () runs, so
+ * that its clock starts with the process.
+ */
+startup_profiler::startup_profiler ()
+    : m_start (clock::now ()), m_steps (), m_step_num (0),
+      m_first_frame_ms (0)
+{
+}
+
+/**@brief Start timing a step
+ *
+ * @param name of the step, a string literal
+ * @return handle of the step for end_step (), -1 if there are too many
+ * steps to keep (the step is not timed then)
+ */
+auto
+startup_profiler::begin_step (const char *name) -> int
+{
+  if (m_step_num == capacity)
+    return -1;
+  m_steps[m_step_num] = { name, since_start (clock::now ()), 0, true };
+  return m_step_num++;
+}
+
+/**@brief Stop timing a step
+ *
+ * Steps deferred until after the first frame are reported as they end.
+ *
+ * @param handle of the step
+ * @param time the step ended, now by default
+ * @return void
+ */
+auto
+startup_profiler::end_step (int step, clock::time_point end) -> void
+{
+  if (step < 0 || !m_steps[step].running)
+    return;
+  auto &ended = m_steps[step];
+  ended.duration_ms = since_start (end) - ended.start_ms;
+  ended.running = false;
+  if (m_first_frame_ms > 0)
+    {
+      printf ("Startup: %s done %.1f ms after start (took %.1f ms)\n",
+              ended.name, ended.start_ms + ended.duration_ms,
+              ended.duration_ms);
+    }
+}
+
+/**@brief Record that the first frame was presented and print the steps that
+ * led to it
+ *
+ * @return void
+ */
+auto
+startup_profiler::first_frame_presented () -> void
+{
+  if (m_first_frame_ms > 0)
+    return;
+  m_first_frame_ms = since_start (clock::now ());
+  print ();
+}
+
+/**@brief Check if the startup is over
+ *
+ * @return true if the first frame was presented and no step is running,
+ * false otherwise
+ */
+auto
+startup_profiler::is_done () const -> bool
+{
+  if (m_first_frame_ms <= 0)
+    return false;
+  for (auto i = 0; i < m_step_num; ++i)
+    {
+      if (m_steps[i].running)
+        return false;
+    }
+  return true;
+}
+
+/**@brief Print the time to the first frame and every step so far, steps
+ * still running are marked as such
+ *
+ * @return void
+ */
+auto
+startup_profiler::print () const -> void
+{
+  printf ("Startup: first frame presented %.1f ms after start\n",
+          m_first_frame_ms);
+  for (auto i = 0; i < m_step_num; ++i)
+    {
+      const auto &step = m_steps[i];
+      if (step.running)
+        printf ("  %-20s at %7.1f ms, running\n", step.name, step.start_ms);
+      else
+        printf ("  %-20s at %7.1f ms, took %7.1f ms%s\n", step.name,
+                step.start_ms, step.duration_ms,
+                step.start_ms + step.duration_ms > m_first_frame_ms
+                    ? " (after the first frame)"
+                    : "");
+    }
+}
+
+/**@brief Append the steps of this run to a CSV file, so that several runs
+ * can be compared
+ *
+ * Every row is a step, the run column (the time the run was saved, in
+ * microseconds) tells the runs apart. The header is written when the file
+ * is empty.
+ *
+ * @param path of the file
+ * @return true if the file was written, false otherwise
+ */
+auto
+startup_profiler::append_csv (const char *path) const -> bool
+{
+  auto *file = fopen (path, "a");
+  if (!file)
+    return false;
+
+  fseek (file, 0, SEEK_END);
+  if (ftell (file) == 0)
+    fprintf (file, "run,step,start_ms,duration_ms\n");
+  const auto run = static_cast<long long> (
+      std::chrono::duration_cast<std::chrono::microseconds> (
+          std::chrono::system_clock::now ().time_since_epoch ())
+          .count ());
+  fprintf (file, "%lld,time to first frame,0.000,%.3f\n", run,
+           m_first_frame_ms);
+  for (auto i = 0; i < m_step_num; ++i)
+    {
+      const auto &step = m_steps[i];
+      if (!step.running)
+        fprintf (file, "%lld,%s,%.3f,%.3f\n", run, step.name, step.start_ms,
+                 step.duration_ms);
+    }
+  return fclose (file) == 0;
+}
+
+/**@brief Milliseconds from the start of the process to a time
+ */
+auto
+startup_profiler::since_start (clock::time_point time) const -> float
+{
+  return std::chrono::duration<float, std::milli> (time - m_start).count ();
+}
@@ -0,0 +1,60 @@
+/**@file startup_profiler.hpp
+ * @brief contains function prototypes for startup profiling
+ *
+ * The startup profiler times every step of the initialization of the app
+ * from the start of the process: the steps that run before the first frame,
+ * the first frame itself and the work deferred until after it (or run
+ * concurrently with it). Steps may overlap, a step can end on another thread
+ * than the one it started on by giving its end time.
+ */
+
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <array>
+#include <chrono>
+
+/**@brief a timed step of the startup
+ */
+struct startup_step
+{
+  const char *name; // string literal
+  float start_ms;   // since the start of the process
+  float duration_ms;
+  bool running;
+};
+
+class startup_profiler
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  static constexpr auto capacity = 32;
+
+  startup_profiler ();
+
+  auto begin_step (const char *name) -> int;
+  auto end_step (int step, clock::time_point end = clock::now ()) -> void;
+  auto first_frame_presented () -> void;
+
+  auto is_done () const -> bool;
+  auto print () const -> void;
+  auto append_csv (const char *path) const -> bool;
+
+  // getters
+  auto
+  get_first_frame_ms () const
+  {
+    return m_first_frame_ms;
+  }
+
+private:
+  auto since_start (clock::time_point time) const -> float;
+
+  clock::time_point m_start;
+  std::array<startup_step, capacity> m_steps;
+  int m_step_num;
+  float m_first_frame_ms; // 0 until the first frame is presented
+};
+
+#endif /* STARTUP_PROFILER_H */
@@ -0,0 +1,119 @@
+/**@file tetromino.cpp
+ * @brief contains the shape data of tetrominos.
+ *
+ */
+
+#include "tetromino.hpp"
+
+// rotation data (uses SRS)
+extern constexpr tetromino
+    tetromino_data[static_cast<int> (tetromino_type::count)]
+    = {
+        // I
+        {
+            {
+                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } },
+                { { 2, 0 }, { 2, 1 }, { 2, 2 }, { 2, 3 } },
+                { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 } },
+                { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 1, 3 } },
+            },
+            0xd0edff, // Light blue
+        },
+        // J
+        {
+            {
+                { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 1, 2 } },
+                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 2, 2 } },
+                { { 1, 0 }, { 1, 1 }, { 0, 2 }, { 1, 2 } },
+            },
+            0xfffed9, // Light yellow
+        },
+        // L
+        {
+            {
+                { { 2, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 2, 2 } },
+                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 0, 2 } },
+                { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 2 } },
+            },
+            0xa9a9a9ff, // Dark gray
+        },
+        // O
+        {
+            {
+                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 2, 0 }, { 1, 1 }, { 2, 1 } },
+            },
+            0xdcdcdcff, // Light gray
+        },
+        // S
+        {
+            {
+                { { 1, 0 }, { 2, 0 }, { 0, 1 }, { 1, 1 } },
+                { { 1, 0 }, { 1, 1 }, { 2, 1 }, { 2, 2 } },
+                { { 1, 1 }, { 2, 1 }, { 0, 2 }, { 1, 2 } },
+                { { 0, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } },
+            },
+            0x98fb98ff, // Pale green
+        },
+        // T
+        {
+            {
+                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 } },
+                { { 1, 0 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
+                { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
+                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, 2 } },
+            },
+            0xe1cff8, // Plum
+        },
+        // Z
+        {
+            {
+                { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 2, 1 } },
+                { { 2, 0 }, { 1, 1 }, { 2, 1 }, { 1, 2 } },
+                { { 0, 1 }, { 1, 1 }, { 1, 2 }, { 2, 2 } },
+                { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 0, 2 } },
+            },
+            0xffb6c1ff, // Light pink
+        }
+    };
+
+/**@brief compute the row masks of every tetromino rotation
+ *
+ * Evaluated at compile time from tetromino_data.
+ * @return table of shapes indexed by tetromino type and rotation
+ */
+static constexpr auto
+make_tetromino_shapes ()
+{
+  std::array<std::array<tetromino_shape, tetromino::rotation_num>,
+             static_cast<int> (tetromino_type::count)>
+      shapes = {};
+  for (auto type = 0; type < static_cast<int> (tetromino_type::count); ++type)
+    {
+      for (auto rotation = 0u; rotation < tetromino::rotation_num; ++rotation)
+        {
+          auto &shape = shapes[type][rotation];
+          const auto &block_coords
+              = tetromino_data[type].block_coords[rotation];
+          for (auto i = 0u; i < tetromino::block_num; ++i)
+            shape.column_bottoms[i] = -1;
+          for (auto i = 0u; i < tetromino::block_num; ++i)
+            {
+              const auto &block = block_coords[i];
+              shape.row_masks[block.y] |= 1u << block.x;
+              if (block.y > shape.column_bottoms[block.x])
+                shape.column_bottoms[block.x] = block.y;
+            }
+        }
+    }
+  return shapes;
+}
+
+extern constexpr std::array<
+    std::array<tetromino_shape, tetromino::rotation_num>,
+    static_cast<int> (tetromino_type::count)>
+    tetromino_shapes = make_tetromino_shapes ();
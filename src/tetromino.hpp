@@ -0,0 +1,63 @@
+/**@file tetromino.hpp
+ * @brief contains the tetromino types and their shape data
+ *
+ * This contains the definition of tetrominos and the rotation data they
+ * follow, shared by the board and the game logic.
+ */
+
+#ifndef TETROMINO_H
+#define TETROMINO_H
+
+#include "utils.hpp"
+#include <array>
+
+struct tetromino
+{
+  static constexpr auto block_num = 4u;
+  static constexpr auto rotation_num = 4u;
+
+  coords block_coords[block_num][rotation_num];
+
+  unsigned int color;
+};
+
+enum class tetromino_type
+{
+  I,
+  J,
+  L,
+  O,
+  S,
+  T,
+  Z,
+  count
+};
+
+struct tetromino_instance
+{
+  tetromino_type m_tetromino_type;
+  coords m_pos;
+  unsigned int m_rotation;
+};
+
+/**@brief shape of one rotation of a tetromino as bit masks
+ *
+ * Bit i of row_masks[j] is set if the tetromino has a block at (i, j) of its
+ * 4x4 box. column_bottoms[i] is the lowest block of column i of the box, -1
+ * if the column is empty.
+ */
+struct tetromino_shape
+{
+  uint8_t row_masks[tetromino::block_num];
+  int8_t column_bottoms[tetromino::block_num];
+};
+
+// rotation data (uses SRS)
+extern const tetromino
+    tetromino_data[static_cast<int> (tetromino_type::count)];
+
+extern const std::array<std::array<tetromino_shape, tetromino::rotation_num>,
+                        static_cast<int> (tetromino_type::count)>
+    tetromino_shapes;
+
+#endif /* TETROMINO_H */
@@ -0,0 +1,162 @@
+/**@file trace.cpp
+ * @brief contains the per thread buffers of the trace recorder.
+ *
+ */
+
+#include "trace.hpp"
+#include <cstdio>
+
+#ifdef TETRIS_ENABLE_TRACE
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**@brief zone recorded by a thread
+ */
+struct trace_event
+{
+  const char *name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+/**@brief ring buffer of the zones of one thread
+ *
+ * Only the owning thread writes events, it publishes them by bumping
+ * `written` so the buffer can be read from another thread. When the ring is
+ * full the oldest events are overwritten, a trace always holds the last
+ * `capacity` zones of every thread.
+ */
+struct trace_buffer
+{
+  static constexpr auto capacity = 1u << 16;
+
+  std::atomic<uint64_t> written;
+  unsigned int thread_id;
+  const char *thread_name;
+  trace_event events[capacity];
+};
+
+// every buffer ever created, they live until the program exits so that the
+// zones of finished threads can still be written
+static std::mutex trace_buffers_mutex;
+static std::vector<std::unique_ptr<trace_buffer>> trace_buffers;
+static const uint64_t trace_start_ns = trace_now ();
+
+static thread_local trace_buffer *thread_buffer = nullptr;
+
+/**@brief Get the buffer of the calling thread, created on first use
+ */
+static auto
+get_thread_buffer () -> trace_buffer &
+{
+  if (!thread_buffer)
+    {
+      std::lock_guard<std::mutex> lock (trace_buffers_mutex);
+      trace_buffers.emplace_back (new trace_buffer ());
+      thread_buffer = trace_buffers.back ().get ();
+      thread_buffer->thread_id = static_cast<unsigned int> (
+          trace_buffers.size ());
+      thread_buffer->thread_name = nullptr;
+    }
+  return *thread_buffer;
+}
+
+/**@brief Store a zone in the buffer of the calling thread
+ *
+ * @param name of the zone
+ * @param start of the zone, from trace_now ()
+ * @param end of the zone, from trace_now ()
+ * @return void
+ */
+auto
+record_trace_event (const char *name, uint64_t start_ns, uint64_t end_ns)
+    -> void
+{
+  auto &buffer = get_thread_buffer ();
+  const auto index = buffer.written.load (std::memory_order_relaxed);
+  buffer.events[index % trace_buffer::capacity]
+      = { name, start_ns, end_ns - start_ns };
+  buffer.written.store (index + 1, std::memory_order_release);
+}
+
+/**@brief Name the calling thread in the trace
+ *
+ * @param name of the thread, must live as long as the program
+ * @return void
+ */
+auto
+set_trace_thread_name (const char *name) -> void
+{
+  get_thread_buffer ().thread_name = name;
+}
+
+/**@brief Write the zones of every thread as Chrome trace-event JSON
+ *
+ * Threads may keep recording while the file is written, their latest zones
+ * are then missing or, if their ring wrapped meanwhile, inconsistent.
+ *
+ * @param path of the file to be written
+ * @return true if the file was written, false otherwise
+ */
+auto
+write_trace_file (const char *path) -> bool
+{
+  auto *file = fopen (path, "w");
+  if (!file)
+    return false;
+
+  std::lock_guard<std::mutex> lock (trace_buffers_mutex);
+  fprintf (file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  auto separator = "";
+  for (const auto &buffer : trace_buffers)
+    {
+      if (buffer->thread_name)
+        {
+          fprintf (file,
+                   "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                   "\"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                   separator, buffer->thread_id, buffer->thread_name);
+          separator = ",\n";
+        }
+
+      const auto written = buffer->written.load (std::memory_order_acquire);
+      const auto first
+          = written > trace_buffer::capacity ? written - trace_buffer::capacity
+                                             : 0;
+      for (auto i = first; i < written; ++i)
+        {
+          const auto &event = buffer->events[i % trace_buffer::capacity];
+          fprintf (file,
+                   "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, "
+                   "\"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+                   separator, event.name,
+                   (event.start_ns - trace_start_ns) / 1000.0,
+                   event.duration_ns / 1000.0, buffer->thread_id);
+          separator = ",\n";
+        }
+    }
+  fprintf (file, "\n]}\n");
+  return fclose (file) == 0;
+}
+
+#else
+
+auto
+set_trace_thread_name (const char *) -> void
+{
+}
+
+auto
+write_trace_file (const char *path) -> bool
+{
+  fprintf (stderr,
+           "Can't write trace %s, tracing is compiled out (build with "
+           "-DTETRIS_ENABLE_TRACE)\n",
+           path);
+  return false;
+}
+
+#endif /* TETRIS_ENABLE_TRACE */
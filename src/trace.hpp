@@ -0,0 +1,67 @@
+/**@file trace.hpp
+ * @brief contains the instrumentation zones of the trace recorder
+ *
+ * TRACE_ZONE ("name") measures the enclosing scope. Every thread writes its
+ * zones into its own fixed size buffer without locking, the buffers are
+ * written as Chrome trace-event JSON (to be opened in Perfetto or
+ * chrome://tracing) by write_trace_file ().
+ *
+ * Zones are only compiled in when TETRIS_ENABLE_TRACE is defined, otherwise
+ * TRACE_ZONE expands to nothing. Zone names must be string literals (or
+ * live as long as the program).
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+auto set_trace_thread_name (const char *name) -> void;
+auto write_trace_file (const char *path) -> bool;
+
+#ifdef TETRIS_ENABLE_TRACE
+
+#include <chrono>
+
+/**@brief current time of the trace clock in nanoseconds
+ */
+inline auto
+trace_now () -> uint64_t
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (
+             std::chrono::steady_clock::now ().time_since_epoch ())
+      .count ();
+}
+
+auto record_trace_event (const char *name, uint64_t start_ns, uint64_t end_ns)
+    -> void;
+
+/**@brief records the time between its construction and its destruction
+ */
+class trace_zone
+{
+public:
+  explicit trace_zone (const char *name) : m_name (name), m_start (trace_now ())
+  {
+  }
+  ~trace_zone () { record_trace_event (m_name, m_start, trace_now ()); }
+
+  trace_zone (const trace_zone &) = delete;
+  trace_zone &operator= (const trace_zone &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_start;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL (a, b)
+#define TRACE_ZONE(name) trace_zone TRACE_CONCAT (trace_zone_, __LINE__) (name)
+
+#else
+
+#define TRACE_ZONE(name) static_cast<void> (0)
+
+#endif /* TETRIS_ENABLE_TRACE */
+
+#endif /* TRACE_H */
@@ -0,0 +1,32 @@
+/**@file transposition_table.cpp
+ * @brief contains the functions of the transposition table.
+ *
+ */
+
+#include "transposition_table.hpp"
+
+/**@brief Constructor of transposition_table class
+ *
+ * @param log2 of the number of slots, every slot takes 16 bytes
+ */
+transposition_table::transposition_table (unsigned int size_log2)
+    : m_slots (new slot[std::size_t (1) << size_log2]),
+      m_mask ((std::size_t (1) << size_log2) - 1)
+{
+  clear ();
+}
+
+/**@brief Forget every stored key
+ *
+ * Not safe while other threads use the table.
+ * @return void
+ */
+auto
+transposition_table::clear () -> void
+{
+  for (auto i = std::size_t (0); i <= m_mask; ++i)
+    {
+      m_slots[i].check.store (0, std::memory_order_relaxed);
+      m_slots[i].value.store (0, std::memory_order_relaxed);
+    }
+}
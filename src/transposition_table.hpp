@@ -0,0 +1,80 @@
+/**@file transposition_table.hpp
+ * @brief contains function prototypes for the transposition table
+ *
+ * A fixed size table from 64 bit keys (board or game state hashes) to 64 bit
+ * values, shared by every thread of a search without locks. Each slot
+ * stores the value and the key XORed with it as two relaxed atomics: a
+ * reader racing a writer may see halves of two different stores, but then
+ * the XOR no longer gives the key back and the probe misses instead of
+ * returning a wrong value. Colliding keys simply replace each other.
+ */
+
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class transposition_table
+{
+public:
+  explicit transposition_table (unsigned int size_log2);
+
+  transposition_table (const transposition_table &) = delete;
+  transposition_table &operator= (const transposition_table &) = delete;
+
+  auto
+  get_size () const
+  {
+    return m_mask + 1;
+  }
+
+  auto clear () -> void;
+
+  /**@brief store the value of a key, replacing whatever used its slot
+   *
+   * @param key, a well mixed hash (its low bits select the slot)
+   * @param value of the key
+   * @return void
+   */
+  auto
+  store (uint64_t key, uint64_t value) -> void
+  {
+    auto &slot = m_slots[key & m_mask];
+    slot.check.store (key ^ value ^ empty_check, std::memory_order_relaxed);
+    slot.value.store (value, std::memory_order_relaxed);
+  }
+
+  /**@brief find the value of a key
+   *
+   * @param key, as given to store ()
+   * @param value of the key if it was found
+   * @return true if the key was found, false otherwise
+   */
+  auto
+  probe (uint64_t key, uint64_t &value) const -> bool
+  {
+    const auto &slot = m_slots[key & m_mask];
+    const auto check = slot.check.load (std::memory_order_relaxed);
+    value = slot.value.load (std::memory_order_relaxed);
+    return (check ^ value ^ empty_check) == key;
+  }
+
+private:
+  // mixed into the check so that zeroed slots don't match the key 0 (the
+  // hash of an empty board)
+  static constexpr uint64_t empty_check = 0x5bd1e9955bd1e995ull;
+
+  struct slot
+  {
+    std::atomic<uint64_t> check; // key ^ value ^ empty_check
+    std::atomic<uint64_t> value;
+  };
+
+  std::unique_ptr<slot[]> m_slots;
+  std::size_t m_mask;
+};
+
+#endif /* TRANSPOSITION_TABLE_H */
@@ -0,0 +1,81 @@
+/**@file triple_buffer.hpp
+ * @brief contains a lock-free triple buffer
+ *
+ * Hands the latest value written by one thread over to one reading thread
+ * without locks and without either of them ever waiting. The writer fills
+ * its own slot and publishes it by swapping it with the shared slot, the
+ * reader swaps its own slot with the shared one whenever a newer value was
+ * published. Values that are published while the reader is busy are simply
+ * replaced by newer ones, the reader always gets the newest.
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+template <typename T> class triple_buffer
+{
+public:
+  triple_buffer () : m_slots (), m_write (0), m_shared (1), m_read (2) {}
+
+  triple_buffer (const triple_buffer &) = delete;
+  triple_buffer &operator= (const triple_buffer &) = delete;
+
+  /**@brief slot the writer fills, only to be used by the writing thread
+   */
+  auto
+  get_write_slot () -> T &
+  {
+    return m_slots[m_write];
+  }
+
+  /**@brief hand the write slot over to the reader, the writer gets the
+   * previously shared slot (whose contents are stale) to write the next value
+   */
+  auto
+  publish () -> void
+  {
+    const auto previous = m_shared.exchange (m_write | fresh_bit,
+                                             std::memory_order_acq_rel);
+    m_write = previous & index_mask;
+  }
+
+  /**@brief take the newest published value, if there is one
+   *
+   * @return true if a value newer than the read slot was taken, false if
+   * the read slot is already the newest
+   */
+  auto
+  acquire () -> bool
+  {
+    if (!(m_shared.load (std::memory_order_relaxed) & fresh_bit))
+      return false;
+    const auto previous
+        = m_shared.exchange (m_read, std::memory_order_acq_rel);
+    m_read = previous & index_mask;
+    return true;
+  }
+
+  /**@brief slot the reader draws from, only to be used by the reading thread
+   */
+  auto
+  get_read_slot () const -> const T &
+  {
+    return m_slots[m_read];
+  }
+
+private:
+  static constexpr unsigned int index_mask = 3;
+  static constexpr unsigned int fresh_bit = 4; // shared slot not read yet
+
+  T m_slots[3];
+  // slot indices, the writer and the reader each own one, the third one is
+  // exchanged between them. Kept on separate cache lines so the two threads
+  // don't slow each other down
+  alignas (64) unsigned int m_write;
+  alignas (64) std::atomic<unsigned int> m_shared;
+  alignas (64) unsigned int m_read;
+};
+
+#endif /* TRIPLE_BUFFER_H */
@@ -1,12 +1,38 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
+
 struct coords
 {
   int x;
   int y;
-  coords () : x (0), y (0) {}
-  coords (int p_x, int p_y) : x (p_x), y (p_y) {}
+  constexpr coords () : x (0), y (0) {}
+  constexpr coords (int p_x, int p_y) : x (p_x), y (p_y) {}
+};
+
+struct colored_rect
+{
+  coords loc;
+  int width;
+  int height;
+  uint32_t rgba_color;
+};
+
+/**@brief sprites of the renderer's block atlas
+ */
+enum class block_sprite : unsigned char
+{
+  filled,
+  outline,
+};
+
+struct block_quad
+{
+  coords loc;
+  int size;
+  uint32_t rgba_color;
+  block_sprite sprite;
 };
 
 #endif /* UTILS_H */
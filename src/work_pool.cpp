@@ -0,0 +1,152 @@
+/**@file work_pool.cpp
+ * @brief contains the functions of the work stealing thread pool.
+ *
+ */
+
+#include "work_pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+/**@brief Constructor of work_pool class
+ *
+ * @param number of threads running the tasks, the calling thread included.
+ * 0 uses every core.
+ */
+work_pool::work_pool (unsigned int thread_num)
+    : m_thread_num (thread_num
+                        ? thread_num
+                        : std::max (1u, std::thread::hardware_concurrency ())),
+      m_queues (new worker_queue[m_thread_num]), m_task (nullptr), m_batch (0),
+      m_busy_num (0), m_stopping (false)
+{
+  // worker 0 is the thread calling run ()
+  for (auto worker = 1u; worker < m_thread_num; ++worker)
+    m_threads.emplace_back (&work_pool::worker_loop, this, worker);
+}
+
+/**@brief Destructor of work_pool class, waits for the workers to exit
+ */
+work_pool::~work_pool ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all ();
+  for (auto &thread : m_threads)
+    thread.join ();
+}
+
+/**@brief Run a batch of tasks and wait for all of them to finish
+ *
+ * Tasks are split in contiguous shares, one per worker. The calling thread
+ * takes part as worker 0.
+ *
+ * @param number of tasks, they are numbered from 0
+ * @param function running a task, given the task and the worker running it
+ * (from 0 to get_thread_num () - 1) so that workers can keep their own
+ * results without locking.
+ * @return void
+ */
+auto
+work_pool::run (std::size_t task_num, const task_function &task) -> void
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    for (auto worker = 0u; worker < m_thread_num; ++worker)
+      {
+        auto &queue = m_queues[worker];
+        std::lock_guard<std::mutex> queue_lock (queue.mutex);
+        const auto begin = task_num * worker / m_thread_num;
+        const auto end = task_num * (worker + 1) / m_thread_num;
+        for (auto i = begin; i < end; ++i)
+          queue.tasks.push_back (i);
+      }
+    m_task = &task;
+    m_busy_num = m_thread_num - 1;
+    ++m_batch;
+  }
+  m_wake.notify_all ();
+
+  run_tasks (0);
+
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_done.wait (lock, [this] () { return m_busy_num == 0; });
+  m_task = nullptr;
+}
+
+/**@brief Wait for batches and run them until the pool is destroyed
+ *
+ * @param index of the worker
+ * @return void
+ */
+auto
+work_pool::worker_loop (unsigned int worker) -> void
+{
+  set_trace_thread_name ("work_pool");
+  auto batch = 0ul;
+  for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_wake.wait (lock, [this, batch] () {
+          return m_stopping || m_batch != batch;
+        });
+        if (m_stopping)
+          return;
+        batch = m_batch;
+      }
+
+      run_tasks (worker);
+
+      std::lock_guard<std::mutex> lock (m_mutex);
+      if (--m_busy_num == 0)
+        m_done.notify_one ();
+    }
+}
+
+/**@brief Run tasks until there are none left in any queue
+ */
+auto
+work_pool::run_tasks (unsigned int worker) -> void
+{
+  std::size_t task;
+  while (pop_task (worker, task))
+    (*m_task) (task, worker);
+}
+
+/**@brief Take the next task of a worker, or steal one from another worker
+ *
+ * A worker takes its own tasks from the back and steals from the front of
+ * the other queues, so both ends rarely meet.
+ *
+ * @param index of the worker
+ * @param task that was taken
+ * @return true if a task was taken, false if every queue is empty
+ */
+auto
+work_pool::pop_task (unsigned int worker, std::size_t &task) -> bool
+{
+  {
+    auto &queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock (queue.mutex);
+    if (!queue.tasks.empty ())
+      {
+        task = queue.tasks.back ();
+        queue.tasks.pop_back ();
+        return true;
+      }
+  }
+  for (auto i = 1u; i < m_thread_num; ++i)
+    {
+      auto &victim = m_queues[(worker + i) % m_thread_num];
+      std::lock_guard<std::mutex> lock (victim.mutex);
+      if (!victim.tasks.empty ())
+        {
+          task = victim.tasks.front ();
+          victim.tasks.pop_front ();
+          return true;
+        }
+    }
+  return false;
+}
@@ -0,0 +1,68 @@
+/**@file work_pool.hpp
+ * @brief contains function prototypes for the work stealing thread pool
+ *
+ * The pool runs batches of independent tasks on every core. Each worker
+ * starts with its own share of the tasks and steals from the others once it
+ * runs out, so batches with uneven tasks (short and long games) still keep
+ * every core busy until the end.
+ */
+
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class work_pool
+{
+public:
+  using task_function
+      = std::function<void (std::size_t task, unsigned int worker)>;
+
+  explicit work_pool (unsigned int thread_num = 0);
+  ~work_pool ();
+
+  work_pool (const work_pool &) = delete;
+  work_pool &operator= (const work_pool &) = delete;
+
+  auto
+  get_thread_num () const
+  {
+    return m_thread_num;
+  }
+
+  auto run (std::size_t task_num, const task_function &task) -> void;
+
+private:
+  /**@brief tasks waiting to be run by a worker
+   */
+  struct worker_queue
+  {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+  };
+
+  auto worker_loop (unsigned int worker) -> void;
+  auto run_tasks (unsigned int worker) -> void;
+  auto pop_task (unsigned int worker, std::size_t &task) -> bool;
+
+  unsigned int m_thread_num; // including the thread calling run ()
+  std::unique_ptr<worker_queue[]> m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  const task_function *m_task;
+  unsigned long m_batch;     // incremented for every batch
+  unsigned int m_busy_num;   // workers still running the current batch
+  bool m_stopping;
+};
+
+#endif /* WORK_POOL_H */